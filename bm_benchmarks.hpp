@@ -0,0 +1,24 @@
+﻿#pragma once
+
+#include <chrono>
+#include <cstddef>
+
+// Mesures de performance lancées par bm_main.cpp, chacune affichant ses résultats sur la sortie standard
+// (elles comparent en général l'implémentation actuelle à celle qu'elle a remplacée, reproduite dans le benchmark)
+void BenchmarkDeadlineScheduler();
+void BenchmarkFreeCellSet();
+void BenchmarkGameStatePacket();
+void BenchmarkSnakeAdvance();
+void BenchmarkSnakeBodyEncoding();
+
+// Exécute `function` `iterations` fois et renvoie la durée moyenne d'un appel (en nanosecondes)
+template<typename F>
+double MeasureAverageTime(std::size_t iterations, F&& function)
+{
+	auto start = std::chrono::steady_clock::now();
+	for (std::size_t i = 0; i < iterations; ++i)
+		function();
+
+	std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+	return elapsed.count() / iterations;
+}
@@ -0,0 +1,199 @@
+﻿#include "bm_benchmarks.hpp"
+#include "sh_random.hpp"
+#include "sv_deadlinescheduler.hpp"
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+// Ces mesures simulent les threads de salles en temps virtuel (chaque tick avançant l'horloge de son thread de son coût),
+// ce qui les rend reproductibles et indépendantes du nombre de coeurs de la machine : seul le DeadlineScheduler est réellement exécuté
+
+namespace
+{
+	struct SchedulingConfig
+	{
+		int workerCount;
+		int roomCount;
+		double load; //< part du temps des threads passée à exécuter des ticks, avant plafonnement des salles les plus chargées
+		double skew; //< exposant de la loi de Zipf donnant le coût des salles (zéro pour des salles identiques)
+	};
+
+	struct SchedulingResult
+	{
+		double load; //< charge réelle, une fois les salles les plus chargées plafonnées
+		double p50; //< retard médian des ticks (en millisecondes)
+		double p99;
+		double max;
+		double stolenPercent; //< part des ticks exécutés par un autre thread que celui de leur salle
+	};
+
+	constexpr sf::Int64 TickInterval = 50'000; //< 20 ticks par seconde (en microsecondes)
+	constexpr sf::Int64 SimulatedDuration = 120'000'000;
+
+	// Sans vol, chaque thread a son propre planificateur (à une seule file) : les salles ne quittent jamais leur thread
+	SchedulingResult SimulateScheduling(const SchedulingConfig& config, bool stealing, const sf::Time& stealDelay)
+	{
+		RandomGenerator random(42);
+
+		// Coût d'un tick de chaque salle, suivant une loi de Zipf (quelques salles très peuplées, beaucoup de petites)
+		std::vector<double> weights(config.roomCount);
+		for (int i = 0; i < config.roomCount; ++i)
+			weights[i] = 1.0 / std::pow(i + 1, config.skew);
+
+		for (int i = config.roomCount - 1; i > 0; --i)
+			std::swap(weights[i], weights[random.GenerateBelow(i + 1)]);
+
+		double totalWeight = 0.0;
+		for (double weight : weights)
+			totalWeight += weight;
+
+		// Les ticks d'une même salle étant séquentiels, une salle ne peut pas prendre plus de 60% de l'intervalle
+		std::vector<sf::Int64> tickCosts(config.roomCount);
+		sf::Int64 totalCost = 0;
+		for (int i = 0; i < config.roomCount; ++i)
+		{
+			tickCosts[i] = std::min<sf::Int64>(static_cast<sf::Int64>(weights[i] / totalWeight * config.load * config.workerCount * TickInterval), TickInterval * 6 / 10);
+			totalCost += tickCosts[i];
+		}
+
+		std::vector<std::unique_ptr<DeadlineScheduler>> schedulers;
+		if (stealing)
+			schedulers.push_back(std::make_unique<DeadlineScheduler>(config.workerCount, stealDelay));
+		else
+		{
+			for (int i = 0; i < config.workerCount; ++i)
+				schedulers.push_back(std::make_unique<DeadlineScheduler>(1, stealDelay));
+		}
+
+		auto getScheduler = [&](int workerIndex) -> DeadlineScheduler& { return *schedulers[(stealing) ? 0 : workerIndex]; };
+		auto getQueueIndex = [&](int workerIndex) -> std::size_t { return (stealing) ? workerIndex : 0; };
+
+		// La salle r appartient au thread r % workerCount, ses ticks commencent à un instant quelconque du premier intervalle
+		for (int roomIndex = 0; roomIndex < config.roomCount; ++roomIndex)
+		{
+			int workerIndex = roomIndex % config.workerCount;
+			sf::Time firstDeadline = sf::microseconds(TickInterval + random.GenerateBelow(TickInterval));
+			getScheduler(workerIndex).Schedule(getQueueIndex(workerIndex), roomIndex + 1, firstDeadline);
+		}
+
+		struct Worker
+		{
+			sf::Int64 time = 0;
+			sf::Int64 runningDeadline = 0;
+			int runningRoom = -1;
+		};
+
+		std::vector<Worker> workers(config.workerCount);
+		std::vector<sf::Int64> lateness;
+		std::size_t stolenCount = 0;
+		for (;;)
+		{
+			// On fait toujours avancer le thread le plus en retard sur l'horloge virtuelle
+			auto workerIt = std::min_element(workers.begin(), workers.end(), [](const Worker& lhs, const Worker& rhs) { return lhs.time < rhs.time; });
+			int workerIndex = static_cast<int>(workerIt - workers.begin());
+			Worker& worker = *workerIt;
+			if (worker.time > SimulatedDuration)
+				break;
+
+			// Fin du tick en cours : le suivant retourne dans la file du thread de la salle
+			if (worker.runningRoom >= 0)
+			{
+				int ownerIndex = worker.runningRoom % config.workerCount;
+				getScheduler(ownerIndex).Schedule(getQueueIndex(ownerIndex), worker.runningRoom + 1, sf::microseconds(worker.runningDeadline + TickInterval));
+				worker.runningRoom = -1;
+			}
+
+			sf::Time now = sf::microseconds(worker.time);
+			if (std::optional<DeadlineScheduler::Task> task = getScheduler(workerIndex).PopDue(getQueueIndex(workerIndex), now))
+			{
+				int roomIndex = static_cast<int>(task->taskId) - 1;
+				lateness.push_back(worker.time - task->deadline.asMicroseconds());
+				if (roomIndex % config.workerCount != workerIndex)
+					stolenCount++;
+
+				worker.runningRoom = roomIndex;
+				worker.runningDeadline = task->deadline.asMicroseconds();
+				worker.time += tickCosts[roomIndex];
+				continue;
+			}
+
+			// Le thread attend sa prochaine échéance, mais peut être réveillé plus tôt par la fin d'un tick d'un autre thread
+			int timeout = getScheduler(workerIndex).GetTimeout(getQueueIndex(workerIndex), now);
+			sf::Int64 wakeTime = (timeout < 0) ? worker.time + 1000 : worker.time + std::max(timeout, 1) * 1000LL;
+			for (const Worker& other : workers)
+			{
+				if (other.runningRoom >= 0 && other.time > worker.time)
+					wakeTime = std::min(wakeTime, other.time);
+			}
+
+			worker.time = std::max(wakeTime, worker.time + 1);
+		}
+
+		std::sort(lateness.begin(), lateness.end());
+		auto getPercentile = [&](double percentile)
+		{
+			return lateness[static_cast<std::size_t>(percentile * (lateness.size() - 1))] / 1000.0;
+		};
+
+		SchedulingResult result;
+		result.load = static_cast<double>(totalCost) / (config.workerCount * TickInterval);
+		result.p50 = getPercentile(0.5);
+		result.p99 = getPercentile(0.99);
+		result.max = lateness.back() / 1000.0;
+		result.stolenPercent = 100.0 * stolenCount / lateness.size();
+
+		return result;
+	}
+
+	void PrintResult(const SchedulingResult& result)
+	{
+		std::cout << std::setw(10) << result.p50 << std::setw(10) << result.p99 << std::setw(11) << result.max;
+	}
+}
+
+void BenchmarkDeadlineScheduler()
+{
+	// Retard des ticks (en millisecondes) lorsque la taille des salles est déséquilibrée, chaque salle restant sur son thread (static)
+	// ou les threads libres volant les ticks en retard des autres (stealing, avec le délai de vol utilisé par le serveur)
+	const sf::Time serverStealDelay = sf::milliseconds(1);
+	const SchedulingConfig configs[] = {
+		{ 8, 64, 0.5, 1.2 },
+		{ 8, 64, 0.7, 1.2 },
+		{ 8, 64, 0.7, 0.8 },
+		{ 4, 32, 0.6, 1.5 },
+		{ 16, 256, 0.7, 1.1 },
+		{ 8, 64, 0.6, 0.0 }
+	};
+
+	std::cout << std::fixed << std::setprecision(2);
+	std::cout << "workers rooms  load  skew |  static p50       p99        max | stealing p50       p99        max    stolen" << std::endl;
+	for (const SchedulingConfig& config : configs)
+	{
+		SchedulingResult staticResult = SimulateScheduling(config, false, serverStealDelay);
+		SchedulingResult stealingResult = SimulateScheduling(config, true, serverStealDelay);
+
+		std::cout << std::setw(7) << config.workerCount << std::setw(6) << config.roomCount << std::setw(6) << stealingResult.load << std::setw(6) << config.skew << " |";
+		PrintResult(staticResult);
+		std::cout << " |  ";
+		PrintResult(stealingResult);
+		std::cout << std::setw(9) << stealingResult.stolenPercent << "%" << std::endl;
+	}
+
+	// Influence du délai de vol : trop court, les salles changent de thread (et de cache) dès le moindre retard de leur thread,
+	// trop long, les ticks en retard attendent d'autant plus longtemps
+	const SchedulingConfig stealDelayConfig = { 8, 64, 0.7, 1.2 };
+
+	std::cout << std::endl << "steal delay (" << stealDelayConfig.workerCount << " workers, " << stealDelayConfig.roomCount << " rooms, skew " << stealDelayConfig.skew << ")";
+	std::cout << " |       p50       p99        max    stolen" << std::endl;
+	for (sf::Int64 stealDelay : { 0, 500, 1000, 2000, 5000, 10000 })
+	{
+		SchedulingResult result = SimulateScheduling(stealDelayConfig, true, sf::microseconds(stealDelay));
+
+		std::cout << std::setw(41) << stealDelay / 1000.0 << " ms |";
+		PrintResult(result);
+		std::cout << std::setw(9) << result.stolenPercent << "%" << std::endl;
+	}
+}
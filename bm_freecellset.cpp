@@ -0,0 +1,90 @@
+﻿#include "bm_benchmarks.hpp"
+#include "sh_freecellset.hpp"
+#include "sh_grid.hpp"
+#include "sh_occupancy.hpp"
+#include "sh_random.hpp"
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+void BenchmarkFreeCellSet()
+{
+	// Tirage d'une cellule libre (pour y placer une pomme) selon le remplissage du terrain : avant, une position était tirée au hasard
+	// puis testée sur la grille et l'occupation des serpents (il faut recommencer tant qu'elle n'est pas libre),
+	// après, la cellule est tirée directement dans le FreeCellSet, qu'il faut en contrepartie tenir à jour à chaque déplacement
+	const int width = 128;
+	const int height = 128;
+	const std::size_t iterations = 2'000'000;
+
+	std::cout << std::setw(10) << "occupancy" << std::setw(16) << "single try (%)" << std::setw(21) << "rejection (ns/pick)";
+	std::cout << std::setw(21) << "free set (ns/pick)" << std::setw(24) << "free set (ns/update)" << std::endl;
+
+	for (int occupancyPercent : { 50, 75, 90, 99 })
+	{
+		RandomGenerator random(occupancyPercent);
+
+		// Les cellules pleines sont pour moitié des murs et pour moitié des pièces de serpent
+		Grid grid(width, height);
+		OccupancyGrid occupancy(width, height);
+		FreeCellSet freeCells(width, height);
+		for (int y = 0; y < height; ++y)
+		{
+			for (int x = 0; x < width; ++x)
+			{
+				sf::Vector2i position(x, y);
+				if (random.GenerateBelow(100) >= static_cast<std::uint32_t>(occupancyPercent))
+					freeCells.Insert(position);
+				else if (random.GenerateBelow(2) == 0)
+					grid.SetCell(x, y, CellType::Wall);
+				else
+					occupancy.AddSegment(position);
+			}
+		}
+
+		auto isFree = [&](const sf::Vector2i& position)
+		{
+			return grid.GetCell(position.x, position.y) == CellType::None && !occupancy.IsOccupied(position);
+		};
+
+		// Proportion de tirages réussis du premier coup (l'ancien code abandonnait la pomme dans le cas contraire)
+		std::size_t successCount = 0;
+		for (std::size_t i = 0; i < iterations; ++i)
+		{
+			sf::Vector2i position(static_cast<int>(random.GenerateBelow(width)), static_cast<int>(random.GenerateBelow(height)));
+			if (isFree(position))
+				successCount++;
+		}
+
+		// Les positions tirées sont accumulées pour que le compilateur ne puisse pas supprimer les tirages
+		long long checksum = 0;
+		double rejectionTime = MeasureAverageTime(iterations, [&]
+		{
+			sf::Vector2i position;
+			do
+			{
+				position = sf::Vector2i(static_cast<int>(random.GenerateBelow(width)), static_cast<int>(random.GenerateBelow(height)));
+			}
+			while (!isFree(position));
+
+			checksum += position.x;
+		});
+
+		double freeSetTime = MeasureAverageTime(iterations, [&]
+		{
+			sf::Vector2i position = freeCells.GetCell(random.GenerateBelow(static_cast<std::uint32_t>(freeCells.GetSize())));
+			checksum += position.x;
+		});
+
+		// Un serpent qui avance libère sa queue et occupe une nouvelle cellule : un retrait et un ajout
+		double updateTime = MeasureAverageTime(iterations, [&]
+		{
+			sf::Vector2i position = freeCells.GetCell(random.GenerateBelow(static_cast<std::uint32_t>(freeCells.GetSize())));
+			freeCells.Remove(position);
+			freeCells.Insert(position);
+			checksum += position.y;
+		});
+
+		std::cout << std::fixed << std::setprecision(2) << std::setw(9) << occupancyPercent << "%" << std::setw(16) << 100.0 * successCount / iterations;
+		std::cout << std::setw(21) << rejectionTime << std::setw(21) << freeSetTime << std::setw(24) << updateTime << ((checksum == 0) ? " " : "") << std::endl;
+	}
+}
@@ -0,0 +1,50 @@
+﻿#include "bm_benchmarks.hpp"
+#include <cstdlib>
+#include <iostream>
+#include <string_view>
+
+namespace
+{
+	struct Benchmark
+	{
+		const char* name;
+		void (*function)();
+	};
+
+	// Les benchmarks sont lancés dans cet ordre, ou individuellement en passant leur nom en paramètre
+	const Benchmark Benchmarks[] = {
+		{ "snake_advance", &BenchmarkSnakeAdvance },
+		{ "game_state_packet", &BenchmarkGameStatePacket },
+		{ "snake_body_encoding", &BenchmarkSnakeBodyEncoding },
+		{ "free_cell_set", &BenchmarkFreeCellSet },
+		{ "deadline_scheduler", &BenchmarkDeadlineScheduler }
+	};
+}
+
+int main(int argc, char** argv)
+{
+	// Les mesures n'ont de sens qu'en Release, les builds de debug n'étant pas optimisés
+#ifdef DEBUG
+	std::cerr << "warning: benchmarks built without optimizations" << std::endl;
+#endif
+
+	bool benchmarkFound = false;
+	for (const Benchmark& benchmark : Benchmarks)
+	{
+		if (argc > 1 && std::string_view(argv[1]) != benchmark.name)
+			continue;
+
+		std::cout << "--- " << benchmark.name << std::endl;
+		benchmark.function();
+
+		benchmarkFound = true;
+	}
+
+	if (!benchmarkFound)
+	{
+		std::cerr << "unknown benchmark " << argv[1] << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,208 @@
+﻿#include "bm_benchmarks.hpp"
+#include "sh_protocol.hpp"
+#include "sh_random.hpp"
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+namespace
+{
+	// Sérialisation avant ByteWriter : chaque champ agrandit le vector (resize) avant d'y être écrit
+	void LegacySerialize_u8(std::vector<std::uint8_t>& byteArray, std::uint8_t value)
+	{
+		std::size_t offset = byteArray.size();
+		byteArray.resize(offset + sizeof(value));
+		byteArray[offset] = value;
+	}
+
+	void LegacySerialize_u16(std::vector<std::uint8_t>& byteArray, std::uint16_t value)
+	{
+		std::size_t offset = byteArray.size();
+		byteArray.resize(offset + sizeof(value));
+		byteArray[offset] = static_cast<std::uint8_t>(value >> 8);
+		byteArray[offset + 1] = static_cast<std::uint8_t>(value);
+	}
+
+	struct BenchmarkSnake
+	{
+		Color color;
+		std::vector<sf::Vector2i> body;
+	};
+
+	std::vector<BenchmarkSnake> BuildSnakes(std::size_t snakeCount, std::size_t bodyLength)
+	{
+		RandomGenerator random(snakeCount * bodyLength);
+
+		std::vector<BenchmarkSnake> snakes(snakeCount);
+		for (BenchmarkSnake& snake : snakes)
+		{
+			snake.color.r = static_cast<std::uint8_t>(random.GenerateBelow(256));
+			snake.color.g = static_cast<std::uint8_t>(random.GenerateBelow(256));
+			snake.color.b = static_cast<std::uint8_t>(random.GenerateBelow(256));
+			snake.body.resize(bodyLength);
+			for (std::size_t i = 0; i < bodyLength; ++i)
+				snake.body[i] = sf::Vector2i(static_cast<int>(i % 100), static_cast<int>(i / 100));
+		}
+
+		return snakes;
+	}
+
+	// Corps dont chaque pièce est voisine de la précédente, comme celui d'un vrai serpent
+	std::vector<sf::Vector2i> BuildChainBody(RandomGenerator& random, std::size_t length)
+	{
+		const sf::Vector2i directions[] = { { 1, 0 }, { -1, 0 }, { 0, 1 }, { 0, -1 } };
+
+		std::vector<sf::Vector2i> body(length);
+		body[0] = sf::Vector2i(100, 100);
+		for (std::size_t i = 1; i < length; ++i)
+			body[i] = body[i - 1] + directions[random.GenerateBelow(4)];
+
+		return body;
+	}
+
+	// Encodage du corps avant la chaîne de directions : sa taille puis chaque position, sur un octet par coordonnée
+	void LegacySerialize_snake_body(ByteWriter& writer, const SnakeBody& body)
+	{
+		writer.EnsureAvailable(2 + body.size() * 2);
+		writer.UncheckedWrite_u16(static_cast<std::uint16_t>(body.size()));
+		for (const sf::Vector2i& pos : body)
+		{
+			writer.UncheckedWrite_u8(static_cast<std::uint8_t>(pos.x));
+			writer.UncheckedWrite_u8(static_cast<std::uint8_t>(pos.y));
+		}
+	}
+
+	// Format de S_GameState au moment du passage à ByteWriter : taille, opcode, nombre de serpents,
+	// puis pour chaque serpent sa couleur, la taille de son corps et la position de chaque pièce (sur un octet par coordonnée)
+	std::vector<std::uint8_t> BuildLegacyGameState(const std::vector<BenchmarkSnake>& snakes)
+	{
+		std::vector<std::uint8_t> packet;
+		LegacySerialize_u16(packet, 0);
+		LegacySerialize_u8(packet, static_cast<std::uint8_t>(Opcode::S_GameState));
+		LegacySerialize_u8(packet, static_cast<std::uint8_t>(snakes.size()));
+		for (const BenchmarkSnake& snake : snakes)
+		{
+			LegacySerialize_u8(packet, snake.color.r);
+			LegacySerialize_u8(packet, snake.color.g);
+			LegacySerialize_u8(packet, snake.color.b);
+			LegacySerialize_u16(packet, static_cast<std::uint16_t>(snake.body.size()));
+			for (const sf::Vector2i& pos : snake.body)
+			{
+				LegacySerialize_u8(packet, static_cast<std::uint8_t>(pos.x));
+				LegacySerialize_u8(packet, static_cast<std::uint8_t>(pos.y));
+			}
+		}
+
+		std::uint16_t size = static_cast<std::uint16_t>(packet.size() - sizeof(std::uint16_t));
+		packet[0] = static_cast<std::uint8_t>(size >> 8);
+		packet[1] = static_cast<std::uint8_t>(size);
+
+		return packet;
+	}
+
+	// Même paquet, construit avec un ByteWriter dont la taille est calculée à l'avance
+	std::vector<std::uint8_t> BuildGameState(const std::vector<BenchmarkSnake>& snakes)
+	{
+		std::size_t packetSize = 2 + 1 + 1;
+		for (const BenchmarkSnake& snake : snakes)
+			packetSize += 3 + 2 + snake.body.size() * 2;
+
+		ByteWriter packet(packetSize);
+		Serialize_u16(packet, 0);
+		Serialize_u8(packet, static_cast<std::uint8_t>(Opcode::S_GameState));
+		Serialize_u8(packet, static_cast<std::uint8_t>(snakes.size()));
+		for (const BenchmarkSnake& snake : snakes)
+		{
+			Serialize_color(packet, snake.color);
+
+			packet.EnsureAvailable(2 + snake.body.size() * 2);
+			packet.UncheckedWrite_u16(static_cast<std::uint16_t>(snake.body.size()));
+			for (const sf::Vector2i& pos : snake.body)
+			{
+				packet.UncheckedWrite_u8(static_cast<std::uint8_t>(pos.x));
+				packet.UncheckedWrite_u8(static_cast<std::uint8_t>(pos.y));
+			}
+		}
+
+		Serialize_u16(packet, 0, static_cast<std::uint16_t>(packet.GetSize() - sizeof(std::uint16_t)));
+
+		return packet.Release();
+	}
+}
+
+void BenchmarkGameStatePacket()
+{
+	// Construction d'un S_GameState pour 64 serpents (le paquet envoyé à chaque tick avant les deltas),
+	// avec resize à chaque champ (avant) ou un ByteWriter réservé une seule fois (après)
+	const std::size_t snakeCount = 64;
+	const std::size_t iterations = 20'000;
+
+	std::cout << std::setw(8) << "length" << std::setw(14) << "bytes" << std::setw(22) << "resize (us/packet)" << std::setw(24) << "ByteWriter (us/packet)" << std::endl;
+	for (std::size_t bodyLength : { 3, 20, 100, 500 })
+	{
+		std::vector<BenchmarkSnake> snakes = BuildSnakes(snakeCount, bodyLength);
+
+		std::vector<std::uint8_t> packet = BuildGameState(snakes);
+		if (packet != BuildLegacyGameState(snakes))
+		{
+			std::cerr << "packets differ for length " << bodyLength << std::endl;
+			continue;
+		}
+
+		// La taille des paquets est accumulée pour que le compilateur ne puisse pas supprimer leur construction
+		std::size_t checksum = 0;
+		double legacyTime = MeasureAverageTime(iterations, [&]
+		{
+			checksum += BuildLegacyGameState(snakes).size();
+		});
+
+		double writerTime = MeasureAverageTime(iterations, [&]
+		{
+			checksum += BuildGameState(snakes).size();
+		});
+
+		std::cout << std::fixed << std::setprecision(2) << std::setw(8) << bodyLength << std::setw(14) << packet.size();
+		std::cout << std::setw(22) << legacyTime / 1000.0 << std::setw(24) << writerTime / 1000.0 << ((checksum == 0) ? " " : "") << std::endl;
+	}
+}
+
+void BenchmarkSnakeBodyEncoding()
+{
+	// Taille et coût d'encodage du corps d'un serpent, position par position (avant) ou sous forme de chaîne de directions (après)
+	const std::size_t iterations = 200'000;
+
+	std::cout << std::setw(8) << "length" << std::setw(16) << "legacy (bytes)" << std::setw(15) << "chain (bytes)";
+	std::cout << std::setw(16) << "legacy (ns)" << std::setw(15) << "chain (ns)" << std::endl;
+
+	RandomGenerator random(42);
+	for (std::size_t length : { 3, 10, 50, 200, 1000 })
+	{
+		Snake snake(BuildChainBody(random, length), sf::Vector2i(1, 0), Color{});
+		SnakeBody body = snake.GetBody();
+
+		ByteWriter legacyWriter;
+		LegacySerialize_snake_body(legacyWriter, body);
+
+		ByteWriter chainWriter;
+		Serialize_snake_body(chainWriter, body);
+
+		// La taille des encodages est accumulée pour que le compilateur ne puisse pas supprimer leur construction
+		std::size_t checksum = 0;
+		double legacyTime = MeasureAverageTime(iterations, [&]
+		{
+			ByteWriter writer(2 + length * 2);
+			LegacySerialize_snake_body(writer, body);
+			checksum += writer.GetSize();
+		});
+
+		double chainTime = MeasureAverageTime(iterations, [&]
+		{
+			ByteWriter writer(2 + length * 2);
+			Serialize_snake_body(writer, body);
+			checksum += writer.GetSize();
+		});
+
+		std::cout << std::fixed << std::setprecision(2) << std::setw(8) << length << std::setw(16) << legacyWriter.GetSize() << std::setw(15) << chainWriter.GetSize();
+		std::cout << std::setw(16) << legacyTime << std::setw(15) << chainTime << ((checksum == 0) ? " " : "") << std::endl;
+	}
+}
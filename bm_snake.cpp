@@ -0,0 +1,80 @@
+﻿#include "bm_benchmarks.hpp"
+#include "sh_snake.hpp"
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+namespace
+{
+	// Stockage du corps avant le buffer circulaire : chaque déplacement décalait toutes les pièces d'un cran
+	class ShiftingSnakeBody
+	{
+	public:
+		explicit ShiftingSnakeBody(std::vector<sf::Vector2i> body) :
+		m_body(std::move(body))
+		{
+		}
+
+		void Advance(const sf::Vector2i& direction)
+		{
+			for (std::size_t i = m_body.size() - 1; i != 0; i--)
+				m_body[i] = m_body[i - 1];
+
+			m_body[0] += direction;
+		}
+
+		const sf::Vector2i& GetHeadPosition() const
+		{
+			return m_body[0];
+		}
+
+	private:
+		std::vector<sf::Vector2i> m_body;
+	};
+
+	// Serpent en ligne droite, la tête en (0, 0) et la queue vers la gauche
+	std::vector<sf::Vector2i> BuildStraightBody(std::size_t length)
+	{
+		std::vector<sf::Vector2i> body(length);
+		for (std::size_t i = 0; i < length; ++i)
+			body[i] = sf::Vector2i(-static_cast<int>(i), 0);
+
+		return body;
+	}
+}
+
+void BenchmarkSnakeAdvance()
+{
+	// Un tick fait avancer chaque serpent d'une case : on mesure ce déplacement selon la longueur du serpent,
+	// avant (décalage de toutes les pièces) et après (buffer circulaire) le changement de stockage du corps
+	const sf::Vector2i direction(1, 0);
+
+	std::cout << std::setw(8) << "length" << std::setw(24) << "shifting (ns/advance)" << std::setw(26) << "ring buffer (ns/advance)" << std::endl;
+	for (std::size_t length : { 3, 10, 100, 1000, 10000 })
+	{
+		// Le décalage coûte une écriture par pièce, on limite le nombre d'itérations pour les grandes longueurs
+		std::size_t shiftingIterations = std::max<std::size_t>(20'000'000 / length, 1000);
+		std::size_t ringIterations = 20'000'000;
+
+		// La position de la tête est accumulée pour que le compilateur ne puisse pas supprimer les déplacements
+		long long checksum = 0;
+
+		ShiftingSnakeBody shiftingBody(BuildStraightBody(length));
+		double shiftingTime = MeasureAverageTime(shiftingIterations, [&]
+		{
+			shiftingBody.Advance(direction);
+			checksum += shiftingBody.GetHeadPosition().x;
+		});
+
+		Snake snake(BuildStraightBody(length), direction, Color{});
+		double ringTime = MeasureAverageTime(ringIterations, [&]
+		{
+			snake.Advance();
+			checksum += snake.GetHeadPosition().x;
+		});
+
+		std::cout << std::fixed << std::setprecision(2) << std::setw(8) << length << std::setw(24) << shiftingTime << std::setw(26) << ringTime;
+		std::cout << ((checksum == 0) ? " " : "") << std::endl;
+	}
+}
@@ -12,27 +12,24 @@ void ClientGrid::Draw(sf::RenderTarget& renderTarget, Resources& resources) cons
 	wallShape.setOutlineColor(sf::Color::Black);
 	wallShape.setOutlineThickness(2.f);
 
-	// On itre sur tous les blocs de la grille pour les afficher ou non
-	for (int y = 0; y < m_height; ++y)
+	// On itre sur les blocs non-vides de la grille pour les afficher
+	ForEachCell([&](int x, int y, CellType cellType)
 	{
-		for (int x = 0; x < m_width; ++x)
+		switch (cellType)
 		{
-			switch (GetCell(x, y))
-			{
-				case CellType::Apple:
-					resources.apple.setPosition(CellSize * x, CellSize * y);
-					renderTarget.draw(resources.apple);
-					break;
+			case CellType::Apple:
+				resources.apple.setPosition(CellSize * x, CellSize * y);
+				renderTarget.draw(resources.apple);
+				break;
 
-				case CellType::Wall:
-					wallShape.setPosition(CellSize * x, CellSize * y);
-					renderTarget.draw(wallShape);
-					break;
+			case CellType::Wall:
+				wallShape.setPosition(CellSize * x, CellSize * y);
+				renderTarget.draw(wallShape);
+				break;
 
-				default:
-					break; //< rien  afficher ici
-			}
+			default:
+				break; //< rien  afficher ici
 		}
-	}
+	});
 }
 
@@ -1,11 +1,14 @@
 #include "sh_constants.hpp"
 #include "sh_protocol.hpp"
+#include "sh_receivebuffer.hpp"
 #include "cl_resources.hpp"
 #include "cl_grid.hpp"
 #include "cl_snake.hpp"
 #include <SFML/Graphics.hpp>
 #include <SFML/Window.hpp>
+#include <cstdlib>
 #include <iostream>
+#include <map>
 #include <optional>
 #include <WinSock2.h>
 #include <ws2tcpip.h>
@@ -13,15 +16,21 @@
 struct GameState
 {
 	std::optional<ClientGrid> clientGrid;
-	std::vector<ClientSnake> clientSnakes;
+	std::map<std::uint32_t, ClientSnake> clientSnakes; //< serpents indexs par leur identifiant, reconstruits  partir des deltas
+	std::optional<std::uint32_t> playerId; //< connu une fois la version du protocole accepte par le serveur
+	std::uint32_t lastTick = 0; //< tick du dernier tat reu, envoy avec chaque direction
 };
 
 const int windowWidth = CellSize * GridWidth;
 const int windowHeight = CellSize * GridHeight;
 
+// Taille maximale (en largeur comme en hauteur) d'une grille envoye par le serveur
+const std::uint32_t MaxGridSize = 4096;
+
 void game(SOCKET sock);
-void handle_message(const std::vector<std::uint8_t>& message, std::size_t offset, GameState& gameState);
-bool receive_message(SOCKET sock, std::vector<std::uint8_t>& pendingData, GameState& gameState);
+bool handle_message(ByteReader& message, GameState& gameState);
+bool receive_message(SOCKET sock, ReceiveBuffer& receiveBuffer, GameState& gameState);
+bool unserialize_snake(ByteReader& message, std::uint32_t snakeId, GameState& gameState);
 
 int main()
 {
@@ -74,6 +83,27 @@ int main()
 		break;
 	}
 
+	std::uint32_t roomId;
+	std::cout << "Please enter room number (" << AnyRoom << " to join any room):" << std::endl;
+	if (!(std::cin >> roomId))
+		roomId = AnyRoom;
+
+	// On commence par indiquer au serveur la version du protocole que nous utilisons, ainsi que la salle que nous souhaitons rejoindre
+	ByteWriter hello(2 + 1 + 5 + 2 + 1 + 5);
+	std::size_t helloSizeOffset = BeginMessage(hello, Opcode::C_Hello);
+	Serialize_varuint(hello, ProtocolVersion);
+	EndMessage(hello, helloSizeOffset);
+
+	std::size_t joinSizeOffset = BeginMessage(hello, Opcode::C_JoinRoom);
+	Serialize_varuint(hello, roomId);
+	EndMessage(hello, joinSizeOffset);
+
+	if (send(sock, reinterpret_cast<const char*>(hello.GetData()), hello.GetSize(), 0) == SOCKET_ERROR)
+	{
+		std::cerr << "failed to send data to server (" << WSAGetLastError() << ")" << std::endl;
+		return EXIT_FAILURE;
+	}
+
 	u_long noBlocking = 1;
 	if (ioctlsocket(sock, FIONBIO, &noBlocking) == SOCKET_ERROR)
 	{
@@ -99,6 +129,9 @@ void game(SOCKET sock)
 	sf::RenderWindow window(sf::VideoMode(windowWidth, windowHeight), "Snake");
 	window.setVerticalSyncEnabled(true);
 
+	// Le serveur garde les directions en file et les applique une par tick : une touche maintenue n'a pas besoin d'tre rpte
+	window.setKeyRepeatEnabled(false);
+
 	// tant donn que l'origine de tous les objets est au centre, il faut dcaler la camra d'autant pour garder
 	// une logique de grille  l'affichage
 	sf::Vector2f viewSize(windowWidth, windowHeight);
@@ -107,7 +140,7 @@ void game(SOCKET sock)
 
 	GameState gameState;
 
-	std::vector<std::uint8_t> pendingData;
+	ReceiveBuffer receiveBuffer;
 
 	while (window.isOpen())
 	{
@@ -150,18 +183,17 @@ void game(SOCKET sock)
 							break;
 					}
 
-					// On applique la direction, si modifie, au serpent
+					// On envoie la direction au serveur, avec le tick de l'tat que nous voyions en la choisissant
 					if (direction)
 					{
-						std::vector<std::uint8_t> packet;
-						std::size_t sizeOffset = packet.size();
-						Serialize_u16(packet, 0);
-						Serialize_u8(packet, static_cast<std::uint8_t>(Opcode::C_UpdateDirection));
+						ByteWriter packet(2 + 1 + 1 + 5);
+						std::size_t sizeOffset = BeginMessage(packet, Opcode::C_UpdateDirection);
 						Serialize_u8(packet, static_cast<std::uint8_t>(*direction));
+						Serialize_varuint(packet, gameState.lastTick);
 
-						Serialize_u16(packet, sizeOffset, packet.size() - sizeof(std::uint16_t));
+						EndMessage(packet, sizeOffset);
 
-						if (send(sock, reinterpret_cast<const char*>(packet.data()), packet.size(), 0) == SOCKET_ERROR)
+						if (send(sock, reinterpret_cast<const char*>(packet.GetData()), packet.GetSize(), 0) == SOCKET_ERROR)
 							std::cerr << "failed to send data to server (" << WSAGetLastError() << ")" << std::endl;
 					}
 					break;
@@ -172,7 +204,7 @@ void game(SOCKET sock)
 			}
 		}
 
-		if (!receive_message(sock, pendingData, gameState))
+		if (!receive_message(sock, receiveBuffer, gameState))
 		{
 			// Got disconnected
 			window.close();
@@ -187,7 +219,7 @@ void game(SOCKET sock)
 			gameState.clientGrid->Draw(window, resources);
 
 		// On affiche le serpent
-		for (ClientSnake& snake : gameState.clientSnakes)
+		for (const auto& [snakeId, snake] : gameState.clientSnakes)
 			snake.Draw(window, resources);
 
 		// On actualise l'affichage de la fentre
@@ -195,69 +227,161 @@ void game(SOCKET sock)
 	}
 }
 
-void handle_message(const std::vector<std::uint8_t>& message, std::size_t offset, GameState& gameState)
+bool handle_message(ByteReader& message, GameState& gameState)
 {
-	Opcode opcode = static_cast<Opcode>(Unserialize_u8(message, offset));
+	Opcode opcode = static_cast<Opcode>(Unserialize_u8(message));
+
+	// Le serveur doit d'abord accepter notre version du protocole
+	if (!gameState.playerId && opcode != Opcode::S_Welcome)
+		return false;
+
 	switch (opcode)
 	{
+		case Opcode::S_Welcome:
+		{
+			std::uint32_t version = Unserialize_varuint(message);
+			std::uint32_t playerId = Unserialize_varuint(message);
+			if (message.HasError() || gameState.playerId || version != ProtocolVersion)
+				return false;
+
+			std::cout << "joined game as player #" << playerId << std::endl;
+			gameState.playerId = playerId;
+			break;
+		}
+
+		case Opcode::S_RoomJoined:
+		{
+			std::uint32_t roomId = Unserialize_varuint(message);
+			if (message.HasError())
+				return false;
+
+			std::cout << "joined room #" << roomId << std::endl;
+			break;
+		}
+
 		case Opcode::S_GameState:
 		{
-			std::uint8_t snakeCount = Unserialize_u8(message, offset);
+			// tat complet : il remplace entirement celui que nous avions reconstruit
+			gameState.lastTick = Unserialize_varuint(message);
+			std::uint32_t snakeCount = Unserialize_varuint(message);
 
 			gameState.clientSnakes.clear();
-			gameState.clientSnakes.reserve(snakeCount);
 
-			for (std::uint8_t i = 0; i < snakeCount; ++i)
+			for (std::uint32_t i = 0; i < snakeCount; ++i)
+			{
+				std::uint32_t snakeId = Unserialize_varuint(message);
+				if (!unserialize_snake(message, snakeId, gameState))
+					return false;
+			}
+			break;
+		}
+
+		case Opcode::S_GameStateDelta:
+		{
+			// Modifications depuis l'tat prcdent, appliques aux serpents que nous connaissons
+			gameState.lastTick = Unserialize_varuint(message);
+			std::uint32_t entryCount = Unserialize_varuint(message);
+			for (std::uint32_t i = 0; i < entryCount; ++i)
 			{
-				Color color = Unserialize_color(message, offset);
-				std::uint16_t snakeBodyParts = Unserialize_u16(message, offset);
-				std::vector<sf::Vector2i> snakeBody(snakeBodyParts);
-				for (sf::Vector2i& pos : snakeBody)
+				std::uint32_t snakeId = Unserialize_varuint(message);
+				SnakeDeltaType deltaType = static_cast<SnakeDeltaType>(Unserialize_u8(message));
+				if (message.HasError())
+					return false;
+
+				switch (deltaType)
 				{
-					pos.x = Unserialize_i8(message, offset);
-					pos.y = Unserialize_i8(message, offset);
-				}
+					case SnakeDeltaType::Moved:
+					case SnakeDeltaType::MovedAndGrew:
+					{
+						sf::Vector2i headPos;
+						headPos.x = static_cast<int>(Unserialize_varuint(message));
+						headPos.y = static_cast<int>(Unserialize_varuint(message));
+
+						auto it = gameState.clientSnakes.find(snakeId);
+						if (message.HasError() || it == gameState.clientSnakes.end())
+							return false;
+
+						// La tte ne peut avancer que d'une seule case, horizontalement ou verticalement
+						ClientSnake& snake = it->second;
+						sf::Vector2i direction = headPos - snake.GetHeadPosition();
+						if (std::abs(direction.x) + std::abs(direction.y) != 1)
+							return false;
+
+						// On reproduit exactement ce qu'a fait le serveur (la queue suit, et la pice ajoute par Grow est calcule de la mme faon)
+						snake.SetFollowingDirection(direction);
+						snake.Advance();
+						if (deltaType == SnakeDeltaType::MovedAndGrew)
+							snake.Grow();
+
+						break;
+					}
+
+					case SnakeDeltaType::Removed:
+						gameState.clientSnakes.erase(snakeId);
+						break;
 
-				gameState.clientSnakes.emplace_back(std::move(snakeBody), sf::Vector2i(1, 0), color);
+					case SnakeDeltaType::Reset:
+					{
+						if (!unserialize_snake(message, snakeId, gameState))
+							return false;
+
+						break;
+					}
+
+					default:
+						return false;
+				}
 			}
 			break;
 		}
 
 		case Opcode::S_GridState:
 		{
-			int gridWidth = Unserialize_u8(message, offset);
-			int gridHeight = Unserialize_u8(message, offset);
+			std::uint32_t gridWidth = Unserialize_varuint(message);
+			std::uint32_t gridHeight = Unserialize_varuint(message);
+			if (message.HasError() || gridWidth > MaxGridSize || gridHeight > MaxGridSize)
+				return false;
 
 			gameState.clientGrid.emplace(gridWidth, gridHeight);
+			if (!Unserialize_grid_cells(message, *gameState.clientGrid))
+				return false;
 
-			std::size_t fullCellCount = Unserialize_u16(message, offset);
-			for (std::size_t i = 0; i < fullCellCount; ++i)
-			{
-				int x = Unserialize_u8(message, offset);
-				int y = Unserialize_u8(message, offset);
-				CellType cellType = static_cast<CellType>(Unserialize_u8(message, offset));
-
-				gameState.clientGrid->SetCell(x, y, cellType);
-			}
 			break;
 		}
 
 		case Opcode::S_GridUpdate:
 		{
-			int x = Unserialize_u8(message, offset);
-			int y = Unserialize_u8(message, offset);
-			CellType cellType = static_cast<CellType>(Unserialize_u8(message, offset));
+			if (!gameState.clientGrid)
+				return false;
+
+			// Toutes les cellules modifies pendant un tick sont regroupes dans le mme message
+			std::uint32_t cellCount = Unserialize_varuint(message);
+			for (std::uint32_t i = 0; i < cellCount; ++i)
+			{
+				std::uint32_t x = Unserialize_varuint(message);
+				std::uint32_t y = Unserialize_varuint(message);
+				CellType cellType = static_cast<CellType>(Unserialize_u8(message));
+
+				if (message.HasError() || cellType > CellType::None || x >= static_cast<std::uint32_t>(gameState.clientGrid->GetWidth()) || y >= static_cast<std::uint32_t>(gameState.clientGrid->GetHeight()))
+					return false;
 
-			gameState.clientGrid->SetCell(x, y, cellType);
+				gameState.clientGrid->SetCell(x, y, cellType);
+			}
 			break;
 		}
+
+		default:
+			return false;
 	}
+
+	// Un message tronqu est considr comme invalide
+	return !message.HasError();
 }
 
-bool receive_message(SOCKET sock, std::vector<std::uint8_t>& pendingData, GameState& gameState)
+bool receive_message(SOCKET sock, ReceiveBuffer& receiveBuffer, GameState& gameState)
 {
-	char buffer[1024];
-	int byteRead = recv(sock, buffer, sizeof(buffer), 0);
+	std::uint8_t* buffer = receiveBuffer.PrepareWrite();
+	int byteRead = recv(sock, reinterpret_cast<char*>(buffer), static_cast<int>(receiveBuffer.GetWritableSize()), 0);
 	if (byteRead == SOCKET_ERROR || byteRead == 0)
 	{
 		// Une erreur s'est produite ou le nombre d'octets lus est de zro, indiquant une dconnexion
@@ -276,30 +400,34 @@ bool receive_message(SOCKET sock, std::vector<std::uint8_t>& pendingData, GameSt
 		return false;
 	}
 
-	std::size_t oldSize = pendingData.size();
-	pendingData.resize(oldSize + byteRead);
-	std::memcpy(&pendingData[oldSize], buffer, byteRead);
+	receiveBuffer.Commit(byteRead);
 
-	while (pendingData.size() >= sizeof(std::uint16_t))
+	while (std::optional<ByteReader> message = receiveBuffer.PopMessage())
 	{
-		// -- Rception du message --
-
-		// On dserialise la taille du message
-		std::uint16_t messageSize;
-		std::memcpy(&messageSize, &pendingData[0], sizeof(messageSize));
-
-		messageSize = ntohs(messageSize);
-
-		if (pendingData.size() - sizeof(messageSize) < messageSize)
-			break;
-
 		// Handle message
-		handle_message(pendingData, sizeof(messageSize), gameState);
+		if (!handle_message(*message, gameState))
+		{
+			std::cerr << "received malformed message from server, disconnecting..." << std::endl;
+			return false;
+		}
+	}
 
-		// On retire la taille que nous de traiter des donnes en attente
-		std::size_t handledSize = sizeof(messageSize) + messageSize;
-		pendingData.erase(pendingData.begin(), pendingData.begin() + handledSize);
+	if (receiveBuffer.HasError())
+	{
+		std::cerr << "received oversized message from server, disconnecting..." << std::endl;
+		return false;
 	}
 
 	return true;
 }
+
+bool unserialize_snake(ByteReader& message, std::uint32_t snakeId, GameState& gameState)
+{
+	Color color = Unserialize_color(message);
+	std::vector<sf::Vector2i> snakeBody = Unserialize_snake_body(message);
+	if (snakeBody.size() < 3)
+		return false;
+
+	gameState.clientSnakes.insert_or_assign(snakeId, ClientSnake(std::move(snakeBody), sf::Vector2i(1, 0), color));
+	return true;
+}
@@ -56,9 +56,10 @@ void ClientSnake::Draw(sf::RenderTarget& renderTarget, Resources& resources) con
 	color.b = m_color.b;
 	color.a = 0xFF;
 
-	for (std::size_t i = 0; i < m_body.size(); ++i)
+	SnakeBody body = GetBody();
+	for (std::size_t i = 0; i < body.size(); ++i)
 	{
-		const auto& pos = m_body[i];
+		const auto& pos = body[i];
 
 		float rotation;
 		sf::Sprite* sprite;
@@ -68,9 +69,9 @@ void ClientSnake::Draw(sf::RenderTarget& renderTarget, Resources& resources) con
 
 			sprite = &resources.snakeHead;
 		}
-		else if (i == m_body.size() - 1)
+		else if (i == body.size() - 1)
 		{
-			sf::Vector2i direction = m_body[i - 1] - m_body[i];
+			sf::Vector2i direction = body[i - 1] - body[i];
 			rotation = computeRotationFromDirection(direction);
 
 			sprite = &resources.snakeTail;
@@ -78,7 +79,7 @@ void ClientSnake::Draw(sf::RenderTarget& renderTarget, Resources& resources) con
 		else
 		{
 			// Dtection des coins, qui ncessitent un traitement diffrent
-			sf::Vector2i direction = m_body[i - 1] - m_body[i + 1];
+			sf::Vector2i direction = body[i - 1] - body[i + 1];
 			if (direction.x == 0 || direction.y == 0)
 			{
 				rotation = computeRotationFromDirection(direction);
@@ -86,7 +87,7 @@ void ClientSnake::Draw(sf::RenderTarget& renderTarget, Resources& resources) con
 			}
 			else
 			{
-				rotation = computeRotationForCorner(m_body[i - 1], m_body[i], m_body[i + 1]);
+				rotation = computeRotationForCorner(body[i - 1], body[i], body[i + 1]);
 				sprite = &resources.snakeBodyCorner;
 			}
 		}
@@ -2,6 +2,9 @@ workspace "Snake"
    configurations { "Debug", "Release" }
    platforms "x64"
 
+-- Le client n'est disponible que sous Windows (Winsock)
+if os.istarget("windows") then
+
 project "Client"
    kind "ConsoleApp"
 
@@ -15,7 +18,7 @@ project "Client"
    sysincludedirs "thirdparty/SFML/include"
 
    files { "**.hpp", "**.cpp" }
-   removefiles "sv_*.*"
+   removefiles { "sv_*.*", "bm_*.*", "ts_*.*" }
 
    links "ws2_32"
 
@@ -30,6 +33,8 @@ project "Client"
       links { "sfml-system", "sfml-window", "sfml-graphics" }
       optimize "On"
 
+end
+
 project "Server"
    kind "ConsoleApp"
 
@@ -39,21 +44,93 @@ project "Server"
    debugdir "bin"
    targetdir "bin"
 
-   libdirs "thirdparty/SFML/lib"
-   sysincludedirs "thirdparty/SFML/include"
-
    files { "**.hpp", "**.cpp" }
-   removefiles "cl_*.*"
+   removefiles { "cl_*.*", "bm_*.*", "ts_*.*" }
 
-   links "ws2_32"
+   -- Sous Linux, la SFML est celle installée sur le système
+   filter "system:windows"
+      libdirs "thirdparty/SFML/lib"
+      sysincludedirs "thirdparty/SFML/include"
+      links "ws2_32"
 
    filter "configurations:Debug"
       defines { "DEBUG" }
-      links "sfml-system-d"
       symbols "On"
       targetsuffix "-d"
 
+   filter { "system:windows", "configurations:Debug" }
+      links "sfml-system-d"
+
+   filter { "system:windows", "configurations:Release" }
+      links "sfml-system"
+
+   -- Les salles sont réparties entre plusieurs threads
+   filter "system:linux"
+      links { "sfml-system", "pthread" }
+
    filter "configurations:Release"
       defines { "NDEBUG" }
+      optimize "On"
+
+-- Mesures de performance du code partagé (à lancer en Release)
+project "Benchmarks"
+   kind "ConsoleApp"
+
+   language "C++"
+   cppdialect "C++17"
+
+   debugdir "bin"
+   targetdir "bin"
+
+   files { "bm_*.hpp", "bm_*.cpp", "sh_*.hpp", "sh_*.cpp", "sv_deadlinescheduler.*" }
+
+   filter "system:windows"
+      libdirs "thirdparty/SFML/lib"
+      sysincludedirs "thirdparty/SFML/include"
+      links "ws2_32"
+
+   filter "configurations:Debug"
+      defines { "DEBUG" }
+      symbols "On"
+      targetsuffix "-d"
+
+   filter { "system:windows", "configurations:Debug" }
+      links "sfml-system-d"
+
+   filter { "system:windows", "configurations:Release" }
       links "sfml-system"
+
+   filter "system:linux"
+      links { "sfml-system", "pthread" }
+
+   filter "configurations:Release"
+      defines { "NDEBUG" }
+      optimize "On"
+
+-- Tests du code partagé (le programme renvoie un code d'erreur si un test échoue)
+project "Tests"
+   kind "ConsoleApp"
+
+   language "C++"
+   cppdialect "C++17"
+
+   debugdir "bin"
+   targetdir "bin"
+
+   files { "ts_*.hpp", "ts_*.cpp", "sh_*.hpp", "sh_*.cpp" }
+
+   filter "system:windows"
+      sysincludedirs "thirdparty/SFML/include"
+      links "ws2_32"
+
+   filter "system:linux"
+      links "pthread"
+
+   filter "configurations:Debug"
+      defines { "DEBUG" }
+      symbols "On"
+      targetsuffix "-d"
+
+   filter "configurations:Release"
+      defines { "NDEBUG" }
       optimize "On"
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// Ce fichier contient des oprations sur les bits d'un entier 64 bits, utilisant les instructions ddies du processeur
+// (std::popcount et std::countr_zero n'existent qu' partir du C++20)
+
+// Renvoie le nombre de bits  un
+inline unsigned int CountBits(std::uint64_t value)
+{
+#ifdef _MSC_VER
+	return static_cast<unsigned int>(__popcnt64(value));
+#else
+	return static_cast<unsigned int>(__builtin_popcountll(value));
+#endif
+}
+
+// Renvoie l'index du bit  un de poids le plus faible (la valeur ne doit pas tre nulle)
+inline unsigned int FindFirstBit(std::uint64_t value)
+{
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward64(&index, value);
+	return static_cast<unsigned int>(index);
+#else
+	return static_cast<unsigned int>(__builtin_ctzll(value));
+#endif
+}
@@ -0,0 +1,109 @@
+#include "sh_broadphase.hpp"
+#include <algorithm>
+#include <tuple>
+
+void CollisionBroadphase::AddSnake(unsigned int snakeId, const Snake& snake)
+{
+	m_snakes.push_back({ &snake, snakeId });
+}
+
+void CollisionBroadphase::Clear()
+{
+	m_snakes.clear();
+}
+
+void CollisionBroadphase::Detect(std::vector<SnakeCollision>& collisions, TaskPool* taskPool)
+{
+	collisions.clear();
+
+	// La table possde au moins deux fois plus d'emplacements que de ttes (et une puissance de deux d'emplacements, pour remplacer le modulo par un masque)
+	std::size_t bucketCount = 1;
+	while (bucketCount < m_snakes.size() * 2)
+		bucketCount *= 2;
+
+	m_bucketMask = bucketCount - 1;
+
+	m_buckets.assign(bucketCount, -1);
+	m_heads.clear();
+	for (const SnakeEntry& entry : m_snakes)
+	{
+		sf::Vector2i headPos = entry.snake->GetHeadPosition();
+		std::int32_t& bucket = m_buckets[HashPosition(headPos) & m_bucketMask];
+
+		m_heads.push_back({ headPos, bucket, entry.snakeId });
+		bucket = static_cast<std::int32_t>(m_heads.size() - 1);
+	}
+
+	// La recherche des pices (l'essentiel du cot) ne fait que lire la table : les serpents sont dcoups en plages conscutives,
+	// chacune tant traite par un thread du pool dans sa propre liste de collisions
+	std::size_t taskCount = 1;
+	if (taskPool)
+	{
+		std::size_t maxTaskCount = std::max<std::size_t>(m_snakes.size() / MinSnakesPerTask, 1);
+		taskCount = std::min(taskPool->GetThreadCount() * TasksPerThread, maxTaskCount);
+	}
+
+	if (taskCount == 1)
+		DetectRange(0, m_snakes.size(), collisions);
+	else
+	{
+		if (m_taskCollisions.size() < taskCount)
+			m_taskCollisions.resize(taskCount);
+
+		taskPool->Run(taskCount, [&](std::size_t taskIndex)
+		{
+			std::size_t firstSnake = m_snakes.size() * taskIndex / taskCount;
+			std::size_t lastSnake = m_snakes.size() * (taskIndex + 1) / taskCount;
+
+			std::vector<SnakeCollision>& taskCollisions = m_taskCollisions[taskIndex];
+			taskCollisions.clear();
+			DetectRange(firstSnake, lastSnake, taskCollisions);
+		});
+
+		for (std::size_t i = 0; i < taskCount; ++i)
+			collisions.insert(collisions.end(), m_taskCollisions[i].begin(), m_taskCollisions[i].end());
+	}
+
+	// Le rsultat ne doit dpendre ni de l'ordre d'ajout des serpents, ni du dcoupage en plages
+	std::sort(collisions.begin(), collisions.end(), [](const SnakeCollision& lhs, const SnakeCollision& rhs)
+	{
+		return std::tie(lhs.snakeId, lhs.otherId, lhs.type) < std::tie(rhs.snakeId, rhs.otherId, rhs.type);
+	});
+}
+
+void CollisionBroadphase::DetectRange(std::size_t firstSnake, std::size_t lastSnake, std::vector<SnakeCollision>& collisions) const
+{
+	// Chaque pice de chaque serpent (tte comprise) est recherche parmi les ttes
+	for (std::size_t snakeIndex = firstSnake; snakeIndex < lastSnake; ++snakeIndex)
+	{
+		const SnakeEntry& entry = m_snakes[snakeIndex];
+
+		SnakeBody body = entry.snake->GetBody();
+		for (std::size_t i = 0; i < body.size(); ++i)
+		{
+			const sf::Vector2i& position = body[i];
+			for (std::int32_t headIndex = m_buckets[HashPosition(position) & m_bucketMask]; headIndex >= 0; headIndex = m_heads[headIndex].next)
+			{
+				const HeadEntry& head = m_heads[headIndex];
+				if (head.position != position)
+					continue;
+
+				if (i == 0)
+				{
+					// Une tte se trouve toujours sur sa propre cellule, seules les autres ttes comptent
+					if (head.snakeId != entry.snakeId)
+						collisions.push_back({ head.snakeId, entry.snakeId, CollisionType::Head });
+				}
+				else
+					collisions.push_back({ head.snakeId, entry.snakeId, (head.snakeId == entry.snakeId) ? CollisionType::Self : CollisionType::Body });
+			}
+		}
+	}
+}
+
+std::size_t CollisionBroadphase::HashPosition(const sf::Vector2i& position)
+{
+	// Multiplication par de grands nombres premiers, les bits de poids fort tant ramens vers le bas pour le masque
+	std::uint64_t hash = static_cast<std::uint64_t>(static_cast<std::uint32_t>(position.x)) * 73856093u ^ static_cast<std::uint64_t>(static_cast<std::uint32_t>(position.y)) * 19349663u;
+	return static_cast<std::size_t>(hash ^ (hash >> 17));
+}
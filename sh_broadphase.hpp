@@ -0,0 +1,77 @@
+#pragma once
+
+#include "sh_snake.hpp"
+#include "sh_taskpool.hpp"
+#include <SFML/System/Vector2.hpp>
+#include <cstdint>
+#include <vector>
+
+// Nature d'une collision entre un serpent et un autre (ou lui-mme)
+enum class CollisionType
+{
+	Body, //< la tte du serpent est entre dans le corps d'un autre serpent
+	Head, //< les ttes des deux serpents sont entres dans la mme cellule
+	Self //< la tte du serpent est entre dans son propre corps
+};
+
+struct SnakeCollision
+{
+	unsigned int snakeId; //< serpent dont la tte est entre en collision
+	unsigned int otherId; //< serpent percut (snakeId lui-mme en cas de CollisionType::Self)
+	CollisionType type;
+};
+
+// La classe CollisionBroadphase dtecte les collisions entre les serpents (une fois ceux-ci tous avancs) :
+// les ttes sont ranges dans une table de hachage spatiale (indexe par cellule), puis chaque pice de chaque serpent
+// y est recherche, ce qui cote un temps proportionnel au nombre total de pices plutt que de tester chaque tte contre chaque corps.
+//
+// Toutes les collisions sont dtectes sur le mme tat (avant que le moindre serpent ne soit retir ou dplac) et sont renvoyes
+// tries, le rsultat ne dpend donc pas de l'ordre dans lequel les serpents ont t ajouts : en cas de collision tte contre tte,
+// les deux serpents sont touchs. Pour la mme raison, la recherche des pices peut tre rpartie entre plusieurs threads
+// (par plages de serpents, chacune produisant sa propre liste) sans changer le rsultat.
+class CollisionBroadphase
+{
+public:
+	CollisionBroadphase() = default;
+
+	// Ajoute un serpent (identifi par snakeId, qui doit tre unique) au prochain appel  Detect
+	// le serpent doit rester valide (et ne pas tre modifi) jusqu' celui-ci
+	void AddSnake(unsigned int snakeId, const Snake& snake);
+
+	// Retire tous les serpents
+	void Clear();
+
+	// Dtecte toutes les collisions entre les serpents ajouts, tries par serpent (puis par serpent percut)
+	// la recherche est rpartie entre les threads de taskPool lorsque les serpents sont assez nombreux
+	void Detect(std::vector<SnakeCollision>& collisions, TaskPool* taskPool = nullptr);
+
+	// Nombre minimum de serpents par plage, en de le cot de la rpartition dpasse le gain
+	static constexpr std::size_t MinSnakesPerTask = 64;
+	// Nombre de plages par thread, pour quilibrer la charge lorsque les serpents n'ont pas tous la mme longueur
+	static constexpr std::size_t TasksPerThread = 4;
+
+private:
+	struct HeadEntry
+	{
+		sf::Vector2i position;
+		std::int32_t next; //< tte suivante du mme emplacement de la table (-1 s'il n'y en a pas)
+		unsigned int snakeId;
+	};
+
+	struct SnakeEntry
+	{
+		const Snake* snake;
+		unsigned int snakeId;
+	};
+
+	// Recherche parmi les ttes les pices des serpents d'une plage (lecture seule, peut tre appele depuis plusieurs threads)
+	void DetectRange(std::size_t firstSnake, std::size_t lastSnake, std::vector<SnakeCollision>& collisions) const;
+
+	static std::size_t HashPosition(const sf::Vector2i& position);
+
+	std::vector<HeadEntry> m_heads;
+	std::vector<SnakeEntry> m_snakes;
+	std::vector<std::int32_t> m_buckets; //< premire tte de chaque emplacement de la table (-1 s'il n'y en a pas)
+	std::vector<std::vector<SnakeCollision>> m_taskCollisions; //< collisions trouves par chaque plage, runies une fois toutes termines
+	std::size_t m_bucketMask = 0;
+};
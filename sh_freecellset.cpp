@@ -0,0 +1,80 @@
+#include "sh_freecellset.hpp"
+#include <cassert>
+
+FreeCellSet::FreeCellSet(int width, int height) :
+m_height(height),
+m_width(width)
+{
+	// Aucune cellule n'est libre au dpart, c'est au propritaire du terrain d'ajouter celles qui le sont
+	m_positions.resize(static_cast<std::size_t>(width) * height, InvalidIndex);
+}
+
+bool FreeCellSet::Contains(const sf::Vector2i& position) const
+{
+	return m_positions[GetCellIndex(position)] != InvalidIndex;
+}
+
+sf::Vector2i FreeCellSet::GetCell(std::size_t index) const
+{
+	assert(index < m_cells.size());
+
+	std::uint32_t cellIndex = m_cells[index];
+	return sf::Vector2i(static_cast<int>(cellIndex % m_width), static_cast<int>(cellIndex / m_width));
+}
+
+std::size_t FreeCellSet::GetSize() const
+{
+	return m_cells.size();
+}
+
+void FreeCellSet::Insert(const sf::Vector2i& position)
+{
+	std::uint32_t cellIndex = GetCellIndex(position);
+	if (m_positions[cellIndex] != InvalidIndex)
+		return;
+
+	m_positions[cellIndex] = static_cast<std::uint32_t>(m_cells.size());
+	m_cells.push_back(cellIndex);
+}
+
+bool FreeCellSet::IsEmpty() const
+{
+	return m_cells.empty();
+}
+
+bool FreeCellSet::IsInside(const sf::Vector2i& position) const
+{
+	return position.x >= 0 && position.x < m_width && position.y >= 0 && position.y < m_height;
+}
+
+void FreeCellSet::Remove(const sf::Vector2i& position)
+{
+	std::uint32_t cellIndex = GetCellIndex(position);
+	std::uint32_t index = m_positions[cellIndex];
+	if (index == InvalidIndex)
+		return;
+
+	// On remplace la cellule par la dernire du tableau, ce qui vite de dcaler toutes les suivantes
+	std::uint32_t lastCellIndex = m_cells.back();
+	m_cells[index] = lastCellIndex;
+	m_positions[lastCellIndex] = index;
+
+	m_cells.pop_back();
+	m_positions[cellIndex] = InvalidIndex;
+}
+
+void FreeCellSet::Update(const sf::Vector2i& position, bool isFree)
+{
+	if (isFree)
+		Insert(position);
+	else
+		Remove(position);
+}
+
+std::uint32_t FreeCellSet::GetCellIndex(const sf::Vector2i& position) const
+{
+	assert(position.x >= 0 && position.x < m_width);
+	assert(position.y >= 0 && position.y < m_height);
+
+	return static_cast<std::uint32_t>(position.y * m_width + position.x);
+}
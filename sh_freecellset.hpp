@@ -0,0 +1,49 @@
+#pragma once
+
+#include <SFML/System/Vector2.hpp>
+#include <cstdint>
+#include <vector>
+
+// La classe FreeCellSet garde la liste des cellules libres du terrain (ni pomme, ni mur, ni serpent),
+// tenue  jour au fur et  mesure que le terrain et les serpents voluent.
+// Les cellules libres sont ranges dans un tableau compact, et chaque cellule connat sa position dans celui-ci :
+// l'ajout, le retrait et le tirage d'une cellule au hasard se font donc en temps constant, quel que soit le remplissage du terrain
+// (l o tirer une position au hasard jusqu' en trouver une libre devient de plus en plus long  mesure que le terrain se remplit).
+class FreeCellSet
+{
+public:
+	FreeCellSet(int width, int height);
+
+	// Teste si une cellule fait partie des cellules libres
+	bool Contains(const sf::Vector2i& position) const;
+
+	// Rcupre une cellule libre  partir d'un index (entre zro et GetSize() exclus), l'ordre des cellules n'ayant aucune signification
+	sf::Vector2i GetCell(std::size_t index) const;
+
+	// Rcupre le nombre de cellules libres
+	std::size_t GetSize() const;
+
+	// Ajoute une cellule aux cellules libres (sans effet si elle en fait dj partie)
+	void Insert(const sf::Vector2i& position);
+
+	bool IsEmpty() const;
+
+	// Teste si une position se trouve dans les limites du terrain
+	bool IsInside(const sf::Vector2i& position) const;
+
+	// Retire une cellule des cellules libres (sans effet si elle n'en fait pas partie)
+	void Remove(const sf::Vector2i& position);
+
+	// Ajoute ou retire une cellule selon qu'elle est libre ou non
+	void Update(const sf::Vector2i& position, bool isFree);
+
+private:
+	static constexpr std::uint32_t InvalidIndex = 0xFFFFFFFF;
+
+	std::uint32_t GetCellIndex(const sf::Vector2i& position) const;
+
+	std::vector<std::uint32_t> m_cells; //< index (y * width + x) des cellules libres
+	std::vector<std::uint32_t> m_positions; //< position de chaque cellule dans m_cells (InvalidIndex si elle n'est pas libre)
+	int m_height;
+	int m_width;
+};
@@ -4,11 +4,51 @@
 
 Grid::Grid(int width, int height) :
 m_height(height),
-m_width(width)
+m_width(width),
+m_wordsPerRow((width + 63) / 64)
 {
-	// On change la taille du vecteur pour qu'il stocke suffisamment de cellules
-	// et on les initialise par dfaut  None
-	m_content.resize(width * height, CellType::None);
+	// On change la taille des plans pour qu'ils stockent suffisamment de cellules
+	// toutes les cellules sont initialement vides (aucun bit  un)
+	for (auto& plane : m_planes)
+		plane.resize(static_cast<std::size_t>(m_wordsPerRow) * height, 0);
+}
+
+std::size_t Grid::CountCells(CellType cellType) const
+{
+	assert(cellType != CellType::None);
+
+	// Les bits de remplissage en fin de ligne sont toujours  zro, on peut donc compter les mots entiers
+	std::size_t count = 0;
+	for (std::uint64_t word : m_planes[static_cast<std::size_t>(cellType)])
+		count += CountBits(word);
+
+	return count;
+}
+
+int Grid::FindEmptyCellInRow(int x, int y) const
+{
+	assert(x >= 0 && x < m_width);
+	assert(y >= 0 && y < m_height);
+
+	std::size_t rowOffset = static_cast<std::size_t>(y) * m_wordsPerRow;
+	for (int word = x / 64; word < m_wordsPerRow; ++word)
+	{
+		std::uint64_t empty = ~std::uint64_t(0);
+		for (const auto& plane : m_planes)
+			empty &= ~plane[rowOffset + word];
+
+		// On ignore les cellules situes avant x
+		if (word == x / 64)
+			empty &= ~std::uint64_t(0) << (x % 64);
+
+		if (empty != 0)
+		{
+			int emptyX = word * 64 + static_cast<int>(FindFirstBit(empty));
+			return (emptyX < m_width) ? emptyX : -1; //< les bits de remplissage en fin de ligne sont considrs vides
+		}
+	}
+
+	return -1;
 }
 
 CellType Grid::GetCell(int x, int y) const
@@ -16,7 +56,15 @@ CellType Grid::GetCell(int x, int y) const
 	assert(x >= 0 && x < m_width);
 	assert(y >= 0 && y < m_height);
 
-	return m_content[y * m_width + x];
+	std::size_t wordIndex = static_cast<std::size_t>(y) * m_wordsPerRow + x / 64;
+	std::uint64_t mask = std::uint64_t(1) << (x % 64);
+	for (std::size_t i = 0; i < PlaneCount; ++i)
+	{
+		if (m_planes[i][wordIndex] & mask)
+			return static_cast<CellType>(i);
+	}
+
+	return CellType::None;
 }
 
 int Grid::GetHeight() const
@@ -34,7 +82,16 @@ void Grid::SetCell(int x, int y, CellType cellType)
 	assert(x >= 0 && x < m_width);
 	assert(y >= 0 && y < m_height);
 
-	m_content[y * m_width + x] = cellType;
+	// Une cellule n'a de bit  un que dans le plan de son type (et dans aucun si elle est vide)
+	std::size_t wordIndex = static_cast<std::size_t>(y) * m_wordsPerRow + x / 64;
+	std::uint64_t mask = std::uint64_t(1) << (x % 64);
+	for (std::size_t i = 0; i < PlaneCount; ++i)
+	{
+		if (static_cast<CellType>(i) == cellType)
+			m_planes[i][wordIndex] |= mask;
+		else
+			m_planes[i][wordIndex] &= ~mask;
+	}
 }
 
 void Grid::SetupWalls()
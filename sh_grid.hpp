@@ -1,5 +1,8 @@
 #pragma once
 
+#include "sh_bits.hpp"
+#include <array>
+#include <cstdint>
 #include <vector>
 
 // Une enum class est comme une enum en C++ classique,  l'exception du fait qu'il est obligatoire d'crire le nom de l'enum
@@ -14,11 +17,24 @@ enum class CellType
 };
 
 // La classe grid reprsente les lments immobiles du terrain, comme les pommes et les murs, dans une grille d'une certaine taille
+//
+// Plutt qu'une CellType par cellule, la grille est stocke sous la forme d'un plan de bits par type de cellule non-vide
+// (un bit  un indiquant que la cellule est de ce type), soit deux bits par cellule.
+// Chaque ligne commence sur un nouveau mot de 64 bits, ce qui permet de parcourir une ligne 64 cellules  la fois.
 class Grid
 {
 public:
 	Grid(int width, int height);
 
+	// Compte les cellules d'un type (pommes ou murs)
+	std::size_t CountCells(CellType cellType) const;
+
+	// Cherche la premire cellule vide d'une ligne  partir de la colonne x (incluse), renvoie -1 s'il n'y en a pas
+	int FindEmptyCellInRow(int x, int y) const;
+
+	// Appelle callback(x, y, cellType) pour chaque cellule non-vide, ligne par ligne
+	template<typename F> void ForEachCell(F&& callback) const;
+
 	// Rcupre le contenu d'une cellule de la grille  une position dfinie
 	CellType GetCell(int x, int y) const;
 	int GetHeight() const;
@@ -29,7 +45,42 @@ public:
 	void SetupWalls();
 
 protected:
-	std::vector<CellType> m_content;
+	static constexpr std::size_t PlaneCount = static_cast<std::size_t>(CellType::None); //< un plan par type de cellule non-vide
+
+	std::array<std::vector<std::uint64_t>, PlaneCount> m_planes;
 	int m_height;
 	int m_width;
+	int m_wordsPerRow;
 };
+
+template<typename F>
+void Grid::ForEachCell(F&& callback) const
+{
+	for (int y = 0; y < m_height; ++y)
+	{
+		std::size_t rowOffset = static_cast<std::size_t>(y) * m_wordsPerRow;
+		for (int word = 0; word < m_wordsPerRow; ++word)
+		{
+			// Les 64 cellules vides sont sautes d'un coup
+			std::uint64_t nonEmpty = 0;
+			for (const auto& plane : m_planes)
+				nonEmpty |= plane[rowOffset + word];
+
+			while (nonEmpty != 0)
+			{
+				unsigned int bit = FindFirstBit(nonEmpty);
+				nonEmpty &= nonEmpty - 1;
+
+				std::uint64_t mask = std::uint64_t(1) << bit;
+				for (std::size_t i = 0; i < PlaneCount; ++i)
+				{
+					if (m_planes[i][rowOffset + word] & mask)
+					{
+						callback(word * 64 + static_cast<int>(bit), y, static_cast<CellType>(i));
+						break;
+					}
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,52 @@
+#include "sh_occupancy.hpp"
+#include <cassert>
+
+OccupancyGrid::OccupancyGrid(int width, int height) :
+m_height(height),
+m_width(width)
+{
+	m_counts.resize(width * height);
+}
+
+void OccupancyGrid::AddSegment(const sf::Vector2i& position)
+{
+	m_counts[GetCellIndex(position)]++;
+}
+
+void OccupancyGrid::AddSnake(const Snake& snake)
+{
+	for (const sf::Vector2i& position : snake.GetBody())
+		AddSegment(position);
+}
+
+std::uint16_t OccupancyGrid::GetCount(const sf::Vector2i& position) const
+{
+	return m_counts[GetCellIndex(position)];
+}
+
+bool OccupancyGrid::IsOccupied(const sf::Vector2i& position) const
+{
+	return GetCount(position) > 0;
+}
+
+void OccupancyGrid::RemoveSegment(const sf::Vector2i& position)
+{
+	std::uint16_t& count = m_counts[GetCellIndex(position)];
+	assert(count > 0);
+
+	count--;
+}
+
+void OccupancyGrid::RemoveSnake(const Snake& snake)
+{
+	for (const sf::Vector2i& position : snake.GetBody())
+		RemoveSegment(position);
+}
+
+std::size_t OccupancyGrid::GetCellIndex(const sf::Vector2i& position) const
+{
+	assert(position.x >= 0 && position.x < m_width);
+	assert(position.y >= 0 && position.y < m_height);
+
+	return position.y * m_width + position.x;
+}
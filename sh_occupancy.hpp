@@ -0,0 +1,41 @@
+#pragma once
+
+#include "sh_snake.hpp"
+#include <SFML/System/Vector2.hpp>
+#include <cstdint>
+#include <vector>
+
+// La classe OccupancyGrid garde uniquement, pour chaque cellule du terrain, le nombre de pices de serpent qui s'y trouvent.
+// Elle est tenue  jour au fur et  mesure que les serpents avancent, grandissent et rapparaissent : une seule lecture suffit
+//  savoir si une cellule est libre, ou si la tte d'un serpent en a percut un autre (plus d'une pice sur sa cellule).
+// Savoir qui a percut qui est le rle de CollisionBroadphase, qui n'est consulte que lorsqu'une telle collision a eu lieu.
+class OccupancyGrid
+{
+public:
+	OccupancyGrid(int width, int height);
+
+	// Ajoute une pice de serpent sur une cellule
+	void AddSegment(const sf::Vector2i& position);
+
+	// Ajoute toutes les pices d'un serpent
+	void AddSnake(const Snake& snake);
+
+	// Rcupre le nombre de pices de serpent prsentes sur une cellule
+	std::uint16_t GetCount(const sf::Vector2i& position) const;
+
+	// Teste si au moins une pice de serpent se trouve sur la cellule
+	bool IsOccupied(const sf::Vector2i& position) const;
+
+	// Retire une pice de serpent d'une cellule
+	void RemoveSegment(const sf::Vector2i& position);
+
+	// Retire toutes les pices d'un serpent
+	void RemoveSnake(const Snake& snake);
+
+private:
+	std::size_t GetCellIndex(const sf::Vector2i& position) const;
+
+	std::vector<std::uint16_t> m_counts; //< nombre de pices de serpent sur chaque cellule
+	int m_height;
+	int m_width;
+};
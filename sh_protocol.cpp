@@ -1,168 +1,602 @@
 #include "sh_protocol.hpp"
+#include "sh_constants.hpp"
+#include "sh_socket.hpp"
+#include <algorithm>
 #include <cassert>
+#include <cstdlib>
 #include <cstring>
-#include <WinSock2.h>
 
-void Serialize_color(std::vector<std::uint8_t>& byteArray, const Color& value)
+namespace
 {
-	Serialize_u8(byteArray, value.r);
-	Serialize_u8(byteArray, value.g);
-	Serialize_u8(byteArray, value.b);
+	// Faon dont le corps d'un serpent est encod
+	enum class SnakeBodyEncoding : std::uint8_t
+	{
+		DirectionChain, //< deux bits par pice (quatre pices par octet)
+		Positions //< deux octets par pice
+	};
+
+	// Dplacement d'une pice  la suivante, index par SnakeDirection
+	const sf::Vector2i ChainDirections[] = { { -1, 0 }, { 1, 0 }, { 0, -1 }, { 0, 1 } };
+
+	// Faon dont le contenu de la grille est encod
+	enum class GridEncoding : std::uint8_t
+	{
+		RunLength, //< une suite de plages (varuint : (longueur - 1) << 2 | type de cellule), idal pour une grille majoritairement vide
+		Bitmap //< deux bits par cellule (quatre cellules par octet), idal pour une grille trs charge
+	};
+
+	// Appelle callback(cellType, length) pour chaque plage de cellules identiques de la grille (parcourue ligne par ligne)
+	// seules les cellules non-vides sont parcourues, les plages vides tant dduites de l'cart entre celles-ci
+	template<typename F>
+	void ForEachGridRun(const Grid& grid, F&& callback)
+	{
+		std::size_t width = static_cast<std::size_t>(grid.GetWidth());
+		std::size_t cellCount = width * grid.GetHeight();
+
+		CellType runType = CellType::None;
+		std::size_t runStart = 0;
+		std::size_t runEnd = 0;
+		grid.ForEachCell([&](int x, int y, CellType cellType)
+		{
+			std::size_t cellIndex = static_cast<std::size_t>(y) * width + x;
+			if (cellIndex == runEnd && cellType == runType)
+			{
+				runEnd++;
+				return;
+			}
+
+			if (runEnd > runStart)
+				callback(runType, static_cast<std::uint32_t>(runEnd - runStart));
+
+			if (cellIndex > runEnd)
+				callback(CellType::None, static_cast<std::uint32_t>(cellIndex - runEnd));
+
+			runType = cellType;
+			runStart = cellIndex;
+			runEnd = cellIndex + 1;
+		});
+
+		if (runEnd > runStart)
+			callback(runType, static_cast<std::uint32_t>(runEnd - runStart));
+
+		if (cellCount > runEnd)
+			callback(CellType::None, static_cast<std::uint32_t>(cellCount - runEnd));
+	}
+
+	std::uint32_t GetGridRunCode(CellType cellType, std::uint32_t length)
+	{
+		return ((length - 1) << 2) | static_cast<std::uint32_t>(cellType);
+	}
+
+	SnakeDirection GetChainDirection(const sf::Vector2i& from, const sf::Vector2i& to)
+	{
+		sf::Vector2i offset = to - from;
+		if (offset.x != 0)
+			return (offset.x < 0) ? SnakeDirection::Left : SnakeDirection::Right;
+		else
+			return (offset.y < 0) ? SnakeDirection::Up : SnakeDirection::Down;
+	}
 }
 
-void Serialize_i8(std::vector<std::uint8_t>& byteArray, std::int8_t value)
+ByteWriter::ByteWriter(std::size_t capacity) :
+m_size(0)
 {
-	return Serialize_u8(byteArray, static_cast<std::uint8_t>(value));
+	Reserve(capacity);
 }
 
-void Serialize_i8(std::vector<std::uint8_t>& byteArray, std::size_t offset, std::int8_t value)
+void ByteWriter::EnsureAvailable(std::size_t size)
 {
-	return Serialize_u8(byteArray, offset, static_cast<std::uint8_t>(value));
+	if (m_buffer.size() - m_size < size)
+		Reserve(std::max(m_size + size, m_buffer.size() * 2));
 }
 
-void Serialize_i16(std::vector<std::uint8_t>& byteArray, std::int16_t value)
+const std::uint8_t* ByteWriter::GetData() const
 {
-	return Serialize_u16(byteArray, static_cast<std::uint16_t>(value));
+	return m_buffer.data();
 }
 
-void Serialize_i16(std::vector<std::uint8_t>& byteArray, std::size_t offset, std::int16_t value)
+std::size_t ByteWriter::GetSize() const
 {
-	return Serialize_u16(byteArray, offset, static_cast<std::uint16_t>(value));
+	return m_size;
 }
 
-void Serialize_i32(std::vector<std::uint8_t>& byteArray, std::int32_t value)
+void ByteWriter::Insert(std::size_t offset, const void* data, std::size_t size)
 {
-	return Serialize_u32(byteArray, static_cast<std::uint32_t>(value));
+	assert(offset <= m_size);
+	EnsureAvailable(size);
+
+	std::memmove(&m_buffer[offset + size], &m_buffer[offset], m_size - offset);
+	std::memcpy(&m_buffer[offset], data, size);
+	m_size += size;
 }
 
-void Serialize_i32(std::vector<std::uint8_t>& byteArray, std::size_t offset, std::int32_t value)
+void ByteWriter::Patch(std::size_t offset, const void* data, std::size_t size)
 {
-	return Serialize_u32(byteArray, offset, static_cast<std::uint32_t>(value));
+	assert(offset + size <= m_size);
+	std::memcpy(&m_buffer[offset], data, size);
 }
 
-void Serialize_u8(std::vector<std::uint8_t>& byteArray, std::uint8_t value)
+std::vector<std::uint8_t> ByteWriter::Release()
 {
-	std::size_t offset = byteArray.size();
-	byteArray.resize(offset + sizeof(value));
+	m_buffer.resize(m_size);
+	m_size = 0;
 
-	return Serialize_u8(byteArray, offset, value);
+	return std::move(m_buffer);
 }
 
-void Serialize_u8(std::vector<std::uint8_t>& byteArray, std::size_t offset, std::uint8_t value)
+void ByteWriter::Reserve(std::size_t capacity)
 {
-	byteArray[offset] = value;
+	if (capacity > m_buffer.size())
+		m_buffer.resize(capacity);
 }
 
-void Serialize_u16(std::vector<std::uint8_t>& byteArray, std::uint16_t value)
+void ByteWriter::Write(const void* data, std::size_t size)
 {
-	std::size_t offset = byteArray.size();
-	byteArray.resize(offset + sizeof(value));
+	EnsureAvailable(size);
+	UncheckedWrite(data, size);
+}
 
-	return Serialize_u16(byteArray, offset, value);
+std::size_t BeginMessage(ByteWriter& writer, Opcode opcode)
+{
+	std::size_t sizeOffset = writer.GetSize();
+	Serialize_u16(writer, 0);
+	Serialize_u8(writer, static_cast<std::uint8_t>(opcode));
+
+	return sizeOffset;
 }
 
-void Serialize_u16(std::vector<std::uint8_t>& byteArray, std::size_t offset, std::uint16_t value)
+void EndMessage(ByteWriter& writer, std::size_t sizeOffset)
 {
-	value = htons(value);
+	std::size_t messageSize = writer.GetSize() - sizeOffset - sizeof(std::uint16_t);
+	if (messageSize < ExtendedMessageSize)
+	{
+		Serialize_u16(writer, sizeOffset, static_cast<std::uint16_t>(messageSize));
+		return;
+	}
+
+	// La taille ne tient pas sur deux octets, on insre la place pour une taille sur quatre octets
+	// (ce qui dcale tout le message, mais ne concerne que de trs gros messages)
+	const std::uint8_t extendedSize[sizeof(std::uint32_t)] = {};
+	writer.Insert(sizeOffset + sizeof(std::uint16_t), extendedSize, sizeof(extendedSize));
+
+	Serialize_u16(writer, sizeOffset, ExtendedMessageSize);
+	Serialize_u32(writer, sizeOffset + sizeof(std::uint16_t), static_cast<std::uint32_t>(messageSize));
+}
+
+void Serialize_color(ByteWriter& writer, const Color& value)
+{
+	writer.EnsureAvailable(3);
+	writer.UncheckedWrite_u8(value.r);
+	writer.UncheckedWrite_u8(value.g);
+	writer.UncheckedWrite_u8(value.b);
+}
+
+void Serialize_grid_cells(ByteWriter& writer, const Grid& grid)
+{
+	// Les deux encodages ne sont pas aussi efficaces selon le contenu de la grille, on calcule la taille de chacun pour garder le plus petit
+	std::size_t cellCount = static_cast<std::size_t>(grid.GetWidth()) * grid.GetHeight();
+	std::size_t bitmapSize = (cellCount + 3) / 4;
+
+	std::size_t runLengthSize = 0;
+	ForEachGridRun(grid, [&](CellType cellType, std::uint32_t length)
+	{
+		runLengthSize += GetVaruintSize(GetGridRunCode(cellType, length));
+	});
+
+	if (runLengthSize <= bitmapSize)
+	{
+		writer.EnsureAvailable(1 + runLengthSize);
+		writer.UncheckedWrite_u8(static_cast<std::uint8_t>(GridEncoding::RunLength));
+
+		ForEachGridRun(grid, [&](CellType cellType, std::uint32_t length)
+		{
+			writer.UncheckedWrite_varuint(GetGridRunCode(cellType, length));
+		});
+
+		return;
+	}
+
+	writer.EnsureAvailable(1 + bitmapSize);
+	writer.UncheckedWrite_u8(static_cast<std::uint8_t>(GridEncoding::Bitmap));
+
+	// Comme pour le corps des serpents, les cellules sont empiles par les bits de poids fort
+	std::uint8_t packed = 0;
+	std::size_t cellIndex = 0;
+	for (int y = 0; y < grid.GetHeight(); ++y)
+	{
+		for (int x = 0; x < grid.GetWidth(); ++x)
+		{
+			packed = static_cast<std::uint8_t>(packed << 2) | static_cast<std::uint8_t>(grid.GetCell(x, y));
+			if (cellIndex++ % 4 == 3)
+			{
+				writer.UncheckedWrite_u8(packed);
+				packed = 0;
+			}
+		}
+	}
+
+	if (cellCount % 4 != 0)
+		writer.UncheckedWrite_u8(static_cast<std::uint8_t>(packed << (2 * (4 - cellCount % 4))));
+}
+
+void Serialize_i8(ByteWriter& writer, std::int8_t value)
+{
+	return Serialize_u8(writer, static_cast<std::uint8_t>(value));
+}
+
+void Serialize_i8(ByteWriter& writer, std::size_t offset, std::int8_t value)
+{
+	return Serialize_u8(writer, offset, static_cast<std::uint8_t>(value));
+}
 
-	assert(offset < byteArray.size() + sizeof(value));
-	std::memcpy(&byteArray[offset], &value, sizeof(value));
+void Serialize_i16(ByteWriter& writer, std::int16_t value)
+{
+	return Serialize_u16(writer, static_cast<std::uint16_t>(value));
+}
+
+void Serialize_i16(ByteWriter& writer, std::size_t offset, std::int16_t value)
+{
+	return Serialize_u16(writer, offset, static_cast<std::uint16_t>(value));
+}
+
+void Serialize_i32(ByteWriter& writer, std::int32_t value)
+{
+	return Serialize_u32(writer, static_cast<std::uint32_t>(value));
+}
+
+void Serialize_i32(ByteWriter& writer, std::size_t offset, std::int32_t value)
+{
+	return Serialize_u32(writer, offset, static_cast<std::uint32_t>(value));
 }
 
-void Serialize_u32(std::vector<std::uint8_t>& byteArray, std::uint32_t value)
+void Serialize_u8(ByteWriter& writer, std::uint8_t value)
 {
-	std::size_t offset = byteArray.size();
-	byteArray.resize(offset + sizeof(value));
+	writer.EnsureAvailable(sizeof(value));
+	writer.UncheckedWrite_u8(value);
+}
 
-	return Serialize_u32(byteArray, offset, value);
+void Serialize_u8(ByteWriter& writer, std::size_t offset, std::uint8_t value)
+{
+	writer.Patch(offset, &value, sizeof(value));
 }
 
-void Serialize_u32(std::vector<std::uint8_t>& byteArray, std::size_t offset, std::uint32_t value)
+void Serialize_u16(ByteWriter& writer, std::uint16_t value)
+{
+	writer.EnsureAvailable(sizeof(value));
+	writer.UncheckedWrite_u16(value);
+}
+
+void Serialize_u16(ByteWriter& writer, std::size_t offset, std::uint16_t value)
+{
+	value = htons(value);
+	writer.Patch(offset, &value, sizeof(value));
+}
+
+void Serialize_u32(ByteWriter& writer, std::uint32_t value)
+{
+	writer.EnsureAvailable(sizeof(value));
+	writer.UncheckedWrite_u32(value);
+}
+
+void Serialize_u32(ByteWriter& writer, std::size_t offset, std::uint32_t value)
 {
 	value = htonl(value);
+	writer.Patch(offset, &value, sizeof(value));
+}
+
+void Serialize_snake_body(ByteWriter& writer, const SnakeBody& body)
+{
+	assert(body.size() > 0);
+
+	bool isChain = true;
+	for (std::size_t i = 1; i < body.size(); ++i)
+	{
+		sf::Vector2i offset = body[i] - body[i - 1];
+		if (std::abs(offset.x) + std::abs(offset.y) != 1)
+		{
+			isChain = false;
+			break;
+		}
+	}
+
+	Serialize_varuint(writer, static_cast<std::uint32_t>(body.size()));
+	Serialize_varuint(writer, static_cast<std::uint32_t>(body[0].x));
+	Serialize_varuint(writer, static_cast<std::uint32_t>(body[0].y));
+
+	std::size_t chainLength = body.size() - 1;
+	if (!isChain)
+	{
+		Serialize_u8(writer, static_cast<std::uint8_t>(SnakeBodyEncoding::Positions));
+		for (std::size_t i = 1; i < body.size(); ++i)
+		{
+			Serialize_varuint(writer, static_cast<std::uint32_t>(body[i].x));
+			Serialize_varuint(writer, static_cast<std::uint32_t>(body[i].y));
+		}
+
+		return;
+	}
+
+	writer.EnsureAvailable(1 + (chainLength + 3) / 4);
+	writer.UncheckedWrite_u8(static_cast<std::uint8_t>(SnakeBodyEncoding::DirectionChain));
+
+	// Les directions sont empiles par les bits de poids fort, le dernier octet tant complt par des zros
+	std::uint8_t packed = 0;
+	for (std::size_t i = 0; i < chainLength; ++i)
+	{
+		packed = static_cast<std::uint8_t>(packed << 2) | static_cast<std::uint8_t>(GetChainDirection(body[i], body[i + 1]));
+		if (i % 4 == 3)
+		{
+			writer.UncheckedWrite_u8(packed);
+			packed = 0;
+		}
+	}
+
+	if (chainLength % 4 != 0)
+		writer.UncheckedWrite_u8(static_cast<std::uint8_t>(packed << (2 * (4 - chainLength % 4))));
+}
+
+void Serialize_str(ByteWriter& writer, const std::string& value)
+{
+	writer.EnsureAvailable(sizeof(std::uint32_t) + value.size());
+	writer.UncheckedWrite_u32(static_cast<std::uint32_t>(value.size()));
+	writer.UncheckedWrite(value.data(), value.size());
+}
 
-	assert(offset < byteArray.size() + sizeof(value));
-	std::memcpy(&byteArray[offset], &value, sizeof(value));
+void Serialize_varuint(ByteWriter& writer, std::uint32_t value)
+{
+	writer.EnsureAvailable(5);
+	writer.UncheckedWrite_varuint(value);
 }
 
-void Serialize_str(std::vector<std::uint8_t>& byteArray, const std::string& value)
+ByteReader::ByteReader(const std::uint8_t* data, std::size_t size) :
+m_data(data),
+m_offset(0),
+m_size(size),
+m_error(false)
 {
-	std::size_t offset = byteArray.size();
-	byteArray.resize(offset + sizeof(std::uint16_t) + value.size());
-	return Serialize_str(byteArray, offset, value);
 }
 
-void Serialize_str(std::vector<std::uint8_t>& byteArray, std::size_t offset, const std::string& value)
+std::size_t ByteReader::GetOffset() const
 {
-	Serialize_u32(byteArray, offset, static_cast<std::uint32_t>(value.size()));
-	offset += sizeof(std::uint32_t);
+	return m_offset;
+}
 
-	std::memcpy(&byteArray[offset], value.data(), value.size());
+std::size_t ByteReader::GetRemaining() const
+{
+	return m_size - m_offset;
 }
 
+bool ByteReader::HasError() const
+{
+	return m_error;
+}
 
-Color Unserialize_color(const std::vector<std::uint8_t>& byteArray, std::size_t& offset)
+const std::uint8_t* ByteReader::Read(std::size_t size)
+{
+	if (m_error || m_size - m_offset < size)
+	{
+		m_error = true;
+		return nullptr;
+	}
+
+	const std::uint8_t* data = m_data + m_offset;
+	m_offset += size;
+
+	return data;
+}
+
+void ByteReader::SetError()
+{
+	m_error = true;
+}
+
+Color Unserialize_color(ByteReader& reader)
 {
 	Color value;
-	value.r = Unserialize_u8(byteArray, offset);
-	value.g = Unserialize_u8(byteArray, offset);
-	value.b = Unserialize_u8(byteArray, offset);
+	value.r = Unserialize_u8(reader);
+	value.g = Unserialize_u8(reader);
+	value.b = Unserialize_u8(reader);
 
 	return value;
 }
 
-std::int8_t Unserialize_i8(const std::vector<std::uint8_t>& byteArray, std::size_t& offset)
+bool Unserialize_grid_cells(ByteReader& reader, Grid& grid)
 {
-	return static_cast<std::int8_t>(Unserialize_u8(byteArray, offset));
+	std::size_t width = static_cast<std::size_t>(grid.GetWidth());
+	std::size_t cellCount = width * grid.GetHeight();
+
+	GridEncoding encoding = static_cast<GridEncoding>(Unserialize_u8(reader));
+	switch (encoding)
+	{
+		case GridEncoding::RunLength:
+		{
+			std::size_t cellIndex = 0;
+			while (cellIndex < cellCount)
+			{
+				std::uint32_t runCode = Unserialize_varuint(reader);
+				std::size_t length = (runCode >> 2) + 1;
+				CellType cellType = static_cast<CellType>(runCode & 0x3);
+				if (reader.HasError() || cellType > CellType::None || length > cellCount - cellIndex)
+					return false;
+
+				// La grille est initialement vide, seules les autres plages ont besoin d'tre appliques
+				if (cellType != CellType::None)
+				{
+					for (std::size_t i = cellIndex; i < cellIndex + length; ++i)
+						grid.SetCell(static_cast<int>(i % width), static_cast<int>(i / width), cellType);
+				}
+
+				cellIndex += length;
+			}
+
+			return true;
+		}
+
+		case GridEncoding::Bitmap:
+		{
+			const std::uint8_t* data = reader.Read((cellCount + 3) / 4);
+			if (!data)
+				return false;
+
+			for (std::size_t i = 0; i < cellCount; ++i)
+			{
+				CellType cellType = static_cast<CellType>((data[i / 4] >> (2 * (3 - i % 4))) & 0x3);
+				if (cellType > CellType::None)
+					return false;
+
+				if (cellType != CellType::None)
+					grid.SetCell(static_cast<int>(i % width), static_cast<int>(i / width), cellType);
+			}
+
+			return true;
+		}
+
+		default:
+			return false;
+	}
 }
 
-std::int16_t Unserialize_i16(const std::vector<std::uint8_t>& byteArray, std::size_t& offset)
+std::int8_t Unserialize_i8(ByteReader& reader)
 {
-	return static_cast<std::int16_t>(Unserialize_u16(byteArray, offset));
+	return static_cast<std::int8_t>(Unserialize_u8(reader));
 }
 
-std::int32_t Unserialize_i32(const std::vector<std::uint8_t>& byteArray, std::size_t& offset)
+std::int16_t Unserialize_i16(ByteReader& reader)
 {
-	return static_cast<std::int32_t>(Unserialize_u32(byteArray, offset));
+	return static_cast<std::int16_t>(Unserialize_u16(reader));
 }
 
-std::uint8_t Unserialize_u8(const std::vector<std::uint8_t>& byteArray, std::size_t& offset)
+std::int32_t Unserialize_i32(ByteReader& reader)
 {
-	std::uint8_t value = byteArray[offset];
-	offset += sizeof(value);
+	return static_cast<std::int32_t>(Unserialize_u32(reader));
+}
 
-	return value;
+std::uint8_t Unserialize_u8(ByteReader& reader)
+{
+	const std::uint8_t* data = reader.Read(sizeof(std::uint8_t));
+	if (!data)
+		return 0;
+
+	return *data;
 }
 
-std::uint16_t Unserialize_u16(const std::vector<std::uint8_t>& byteArray, std::size_t& offset)
+std::uint16_t Unserialize_u16(ByteReader& reader)
 {
 	std::uint16_t value;
-	std::memcpy(&value, &byteArray[offset], sizeof(value));
-	value = ntohs(value);
-
-	offset += sizeof(value);
+	const std::uint8_t* data = reader.Read(sizeof(value));
+	if (!data)
+		return 0;
 
-	return value;
+	std::memcpy(&value, data, sizeof(value));
+	return ntohs(value);
 }
 
-std::uint32_t Unserialize_u32(const std::vector<std::uint8_t>& byteArray, std::size_t& offset)
+std::uint32_t Unserialize_u32(ByteReader& reader)
 {
 	std::uint32_t value;
-	std::memcpy(&value, &byteArray[offset], sizeof(value));
-	value = ntohl(value);
+	const std::uint8_t* data = reader.Read(sizeof(value));
+	if (!data)
+		return 0;
 
-	offset += sizeof(value);
+	std::memcpy(&value, data, sizeof(value));
+	return ntohl(value);
+}
 
-	return value;
+std::vector<sf::Vector2i> Unserialize_snake_body(ByteReader& reader)
+{
+	std::uint32_t length = Unserialize_varuint(reader);
+	sf::Vector2i headPos;
+	headPos.x = static_cast<int>(Unserialize_varuint(reader));
+	headPos.y = static_cast<int>(Unserialize_varuint(reader));
+	SnakeBodyEncoding encoding = static_cast<SnakeBodyEncoding>(Unserialize_u8(reader));
+
+	if (reader.HasError() || length == 0)
+	{
+		reader.SetError();
+		return {};
+	}
+
+	std::size_t chainLength = length - 1;
+	switch (encoding)
+	{
+		case SnakeBodyEncoding::DirectionChain:
+		{
+			// Toutes les directions sont lues d'un coup, ce qui garantit qu'elles sont prsentes avant d'allouer le corps
+			const std::uint8_t* data = reader.Read((chainLength + 3) / 4);
+			if (!data)
+				return {};
+
+			std::vector<sf::Vector2i> body(length);
+			body[0] = headPos;
+			for (std::size_t i = 0; i < chainLength; ++i)
+			{
+				unsigned int direction = (data[i / 4] >> (2 * (3 - i % 4))) & 0x3;
+				body[i + 1] = body[i] + ChainDirections[direction];
+			}
+
+			return body;
+		}
+
+		case SnakeBodyEncoding::Positions:
+		{
+			// Chaque position occupe au moins deux octets
+			if (reader.GetRemaining() / 2 < chainLength)
+			{
+				reader.SetError();
+				return {};
+			}
+
+			std::vector<sf::Vector2i> body(length);
+			body[0] = headPos;
+			for (std::size_t i = 0; i < chainLength; ++i)
+			{
+				body[i + 1].x = static_cast<int>(Unserialize_varuint(reader));
+				body[i + 1].y = static_cast<int>(Unserialize_varuint(reader));
+			}
+
+			if (reader.HasError())
+				return {};
+
+			return body;
+		}
+
+		default:
+			reader.SetError();
+			return {};
+	}
 }
 
-std::string Unserialize_str(const std::vector<std::uint8_t>& byteArray, std::size_t& offset)
+std::string_view Unserialize_str(ByteReader& reader)
 {
-	std::uint32_t length = Unserialize_u32(byteArray, offset);
-	std::string str(length, ' ');
-	std::memcpy(&str[0], &byteArray[offset], length);
+	std::uint32_t length = Unserialize_u32(reader);
+	const std::uint8_t* data = reader.Read(length);
+	if (!data)
+		return {};
 
-	offset += length;
+	return std::string_view(reinterpret_cast<const char*>(data), length);
+}
 
-	return str;
+std::uint32_t Unserialize_varuint(ByteReader& reader)
+{
+	std::uint32_t value = 0;
+	for (unsigned int shift = 0; shift < 32; shift += 7)
+	{
+		const std::uint8_t* data = reader.Read(sizeof(std::uint8_t));
+		if (!data)
+			return 0;
+
+		value |= static_cast<std::uint32_t>(*data & 0x7F) << shift;
+		if ((*data & 0x80) == 0)
+		{
+			// Le cinquime octet ne peut contenir que les quatre bits de poids fort
+			if (shift == 28 && *data > 0x0F)
+				break;
+
+			return value;
+		}
+	}
+
+	// Valeur trop grande pour 32 bits
+	reader.SetError();
+	return 0;
 }
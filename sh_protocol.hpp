@@ -1,41 +1,219 @@
 #pragma once
 
 #include "sh_color.hpp"
+#include "sh_grid.hpp"
+#include "sh_snake.hpp"
+#include <SFML/System/Vector2.hpp>
 #include <cstdint>
+#include <cstring>
 #include <string>
+#include <string_view>
 #include <vector>
 
 // Ce fichier contient tout ce qui va tre li au protocole du jeu,  la faon dont le client et le serveur vont communiquer
 
+// Version du protocole, ngocie  la connexion : le client envoie C_Hello avec la version la plus rcente qu'il comprend,
+// le serveur rpond S_Welcome avec la version utilise (ou ferme la connexion s'il ne la supporte pas).
+// Elle doit tre incrmente  chaque modification du format des messages
+const std::uint32_t ProtocolVersion = 5;
+
+// Le client choisit ensuite une salle avec C_JoinRoom (identifiant  partir de 1), AnyRoom laissant le serveur choisir la moins remplie :
+// S_Welcome n'est envoy qu'une fois la salle rejointe (une version non supporte entrane en revanche la fermeture immdiate)
+const std::uint32_t AnyRoom = 0;
+
+// Les messages commencent par leur taille sur deux octets, cette valeur indiquant que la vraie taille suit sur quatre octets
+const std::uint16_t ExtendedMessageSize = 0xFFFF;
+
+// Les coordonnes, nombres et tailles sont envoys sous forme d'entiers de taille variable (varuint),
+// ce qui ne cote qu'un octet pour les valeurs infrieures  128 sans limiter la taille de la grille ou le nombre de joueurs
+
 enum class Opcode : std::uint8_t
 {
-	C_UpdateDirection,
-	S_GameState,
+	C_UpdateDirection, //< direction demande, suivie du tick du dernier tat reu (le serveur ignore les directions trop anciennes)
+	S_GameState, //< tick, puis tat complet de tous les serpents (keyframe)
 	S_GridState,
-	S_GridUpdate
+	S_GridUpdate, //< cellules de la grille modifies pendant le tick
+	S_GameStateDelta, //< tick, puis modifications des serpents depuis le tick prcdent
+
+	// Poigne de main, le format de ces deux messages (et la valeur de leur opcode) ne doit jamais changer d'une version  l'autre
+	C_Hello,
+	S_Welcome,
+
+	C_JoinRoom, //< salle que le joueur souhaite rejoindre (ou AnyRoom), envoy aprs C_Hello
+	S_RoomJoined //< salle rejointe par le joueur, suivie de l'tat de la partie
+};
+
+// Nature d'une entre de S_GameStateDelta (chacune tant prcde de l'identifiant du serpent concern)
+enum class SnakeDeltaType : std::uint8_t
+{
+	Moved, //< la tte a avanc d'une case (position de la nouvelle tte) et la queue a t retire
+	MovedAndGrew, //< idem, puis le serpent a grandi d'une pice
+	Removed, //< le serpent a disparu (joueur dconnect)
+	Reset //< le serpent est apparu ou rapparu (couleur et corps complet)
+};
+
+// La classe ByteWriter sert  construire un paquet octet par octet.
+// Contrairement  un std::vector auquel on ajouterait les octets un  un (resize  chaque champ, donc une rallocation
+// et une mise  zro potentielles  chaque fois), la mmoire n'est rserve qu'une fois : l'idal est d'indiquer ds la construction
+// la taille attendue du paquet, puis d'appeler EnsureAvailable avant une srie d'critures Unchecked* qui ne testent plus la capacit.
+class ByteWriter
+{
+public:
+	explicit ByteWriter(std::size_t capacity = 0);
+
+	// Garantit que `size` octets peuvent encore tre crits sans rallocation
+	void EnsureAvailable(std::size_t size);
+
+	const std::uint8_t* GetData() const;
+	std::size_t GetSize() const;
+
+	// Insre des octets au milieu du paquet (en dcalant les suivants)
+	void Insert(std::size_t offset, const void* data, std::size_t size);
+
+	// Rcrit des octets dj prsents dans le paquet (pour y inscrire une taille connue seulement  la fin par exemple)
+	void Patch(std::size_t offset, const void* data, std::size_t size);
+
+	// Rcupre le contenu du paquet sous forme de vector (le ByteWriter est vid)
+	std::vector<std::uint8_t> Release();
+
+	// Rserve la mmoire pour un paquet d'au moins `capacity` octets
+	void Reserve(std::size_t capacity);
+
+	// Ajoute des octets au paquet
+	void Write(const void* data, std::size_t size);
+
+	// Ajoute des octets au paquet, sans vrifier la capacit (EnsureAvailable doit avoir t appele)
+	inline void UncheckedWrite(const void* data, std::size_t size);
+	inline void UncheckedWrite_u8(std::uint8_t value);
+	inline void UncheckedWrite_u16(std::uint16_t value);
+	inline void UncheckedWrite_u32(std::uint32_t value);
+	inline void UncheckedWrite_varuint(std::uint32_t value);
+
+private:
+	std::vector<std::uint8_t> m_buffer; //< toujours de la taille de la capacit, seuls les m_size premiers octets sont utiliss
+	std::size_t m_size;
+};
+
+// Commence un message : rserve la place de sa taille et crit son opcode, renvoie la position de la taille  passer  EndMessage
+std::size_t BeginMessage(ByteWriter& writer, Opcode opcode);
+// Termine un message en crivant sa taille (celle-ci n'incluant pas les octets de la taille elle-mme)
+// au-del de 64Kio, la taille est remplace par ExtendedMessageSize suivie de la vraie taille sur quatre octets
+void EndMessage(ByteWriter& writer, std::size_t sizeOffset);
+
+void Serialize_color(ByteWriter& writer, const Color& value);
+// Le contenu de la grille (sans ses dimensions, qui doivent tre envoyes avant) est encod soit par plages de cellules identiques,
+// soit sur deux bits par cellule, l'encodage le plus compact tant choisi automatiquement
+void Serialize_grid_cells(ByteWriter& writer, const Grid& grid);
+void Serialize_i8(ByteWriter& writer, std::int8_t value);
+void Serialize_i8(ByteWriter& writer, std::size_t offset, std::int8_t value);
+void Serialize_i16(ByteWriter& writer, std::int16_t value);
+void Serialize_i16(ByteWriter& writer, std::size_t offset, std::int16_t value);
+void Serialize_i32(ByteWriter& writer, std::int32_t value);
+void Serialize_i32(ByteWriter& writer, std::size_t offset, std::int32_t value);
+void Serialize_u8(ByteWriter& writer, std::uint8_t value);
+void Serialize_u8(ByteWriter& writer, std::size_t offset, std::uint8_t value);
+void Serialize_u16(ByteWriter& writer, std::uint16_t value);
+void Serialize_u16(ByteWriter& writer, std::size_t offset, std::uint16_t value);
+void Serialize_u32(ByteWriter& writer, std::uint32_t value);
+void Serialize_u32(ByteWriter& writer, std::size_t offset, std::uint32_t value);
+// Le corps d'un serpent est envoy sous la forme de la position de sa tte suivie de la direction (sur deux bits) menant  chaque pice suivante,
+// chaque pice tant voisine de la prcdente (les positions sont envoyes telles quelles dans le cas contraire, qui ne devrait pas se produire)
+void Serialize_snake_body(ByteWriter& writer, const SnakeBody& body);
+void Serialize_str(ByteWriter& writer, const std::string& value);
+// Sept bits par octet, le bit de poids fort indiquant qu'un octet suit (LEB128)
+void Serialize_varuint(ByteWriter& writer, std::uint32_t value);
+
+// Renvoie le nombre d'octets occups par un varuint
+inline std::size_t GetVaruintSize(std::uint32_t value);
+
+// La classe ByteReader permet de lire un message octet par octet, directement depuis la mmoire o il a t reu (sans copie).
+// Chaque lecture vrifie qu'il reste assez de donnes : si ce n'est pas le cas, la lecture renvoie une valeur nulle
+// et le reader passe en erreur (toutes les lectures suivantes chouant galement), il suffit donc de tester HasError
+// une fois le message lu pour savoir s'il tait tronqu.
+class ByteReader
+{
+public:
+	ByteReader(const std::uint8_t* data, std::size_t size);
+
+	std::size_t GetOffset() const;
+	std::size_t GetRemaining() const;
+
+	// Indique si une lecture a chou faute de donnes (ou si une valeur invalide a t lue)
+	bool HasError() const;
+
+	// Lit `size` octets et renvoie un pointeur sur ceux-ci (valide tant que la mmoire lue l'est), ou nullptr en cas d'erreur
+	const std::uint8_t* Read(std::size_t size);
+
+	// Met le reader en erreur, lorsqu'une valeur lue est invalide
+	void SetError();
+
+private:
+	const std::uint8_t* m_data;
+	std::size_t m_offset;
+	std::size_t m_size;
+	bool m_error;
 };
 
-void Serialize_color(std::vector<std::uint8_t>& byteArray, const Color& value);
-void Serialize_i8(std::vector<std::uint8_t>& byteArray, std::int8_t value);
-void Serialize_i8(std::vector<std::uint8_t>& byteArray, std::size_t offset, std::int8_t value);
-void Serialize_i16(std::vector<std::uint8_t>& byteArray, std::int16_t value);
-void Serialize_i16(std::vector<std::uint8_t>& byteArray, std::size_t offset, std::int16_t value);
-void Serialize_i32(std::vector<std::uint8_t>& byteArray, std::int32_t value); 
-void Serialize_i32(std::vector<std::uint8_t>& byteArray, std::size_t offset, std::int32_t value);
-void Serialize_u8(std::vector<std::uint8_t>& byteArray, std::uint8_t value);
-void Serialize_u8(std::vector<std::uint8_t>& byteArray, std::size_t offset, std::uint8_t value);
-void Serialize_u16(std::vector<std::uint8_t>& byteArray, std::uint16_t value);
-void Serialize_u16(std::vector<std::uint8_t>& byteArray, std::size_t offset, std::uint16_t value);
-void Serialize_u32(std::vector<std::uint8_t>& byteArray, std::uint32_t value);
-void Serialize_u32(std::vector<std::uint8_t>& byteArray, std::size_t offset, std::uint32_t value);
-void Serialize_str(std::vector<std::uint8_t>& byteArray, const std::string& value);
-void Serialize_str(std::vector<std::uint8_t>& byteArray, std::size_t offset, const std::string& value);
-
-Color Unserialize_color(const std::vector<std::uint8_t>& byteArray, std::size_t& offset);
-std::int8_t Unserialize_i8(const std::vector<std::uint8_t>& byteArray, std::size_t& offset);
-std::int16_t Unserialize_i16(const std::vector<std::uint8_t>& byteArray, std::size_t& offset);
-std::int32_t Unserialize_i32(const std::vector<std::uint8_t>& byteArray, std::size_t& offset);
-std::uint8_t Unserialize_u8(const std::vector<std::uint8_t>& byteArray, std::size_t& offset);
-std::uint16_t Unserialize_u16(const std::vector<std::uint8_t>& byteArray, std::size_t& offset);
-std::uint32_t Unserialize_u32(const std::vector<std::uint8_t>& byteArray, std::size_t& offset);
-std::string Unserialize_str(const std::vector<std::uint8_t>& byteArray, std::size_t& offset);
\ No newline at end of file
+Color Unserialize_color(ByteReader& reader);
+// Remplit une grille (vide, aux dimensions dj connues)  partir de son contenu, renvoie false si les donnes sont invalides
+bool Unserialize_grid_cells(ByteReader& reader, Grid& grid);
+std::int8_t Unserialize_i8(ByteReader& reader);
+std::int16_t Unserialize_i16(ByteReader& reader);
+std::int32_t Unserialize_i32(ByteReader& reader);
+std::uint8_t Unserialize_u8(ByteReader& reader);
+std::uint16_t Unserialize_u16(ByteReader& reader);
+std::uint32_t Unserialize_u32(ByteReader& reader);
+// Renvoie un corps vide si les donnes sont invalides
+std::vector<sf::Vector2i> Unserialize_snake_body(ByteReader& reader);
+// La chane renvoye pointe directement sur les donnes lues
+std::string_view Unserialize_str(ByteReader& reader);
+std::uint32_t Unserialize_varuint(ByteReader& reader);
+
+inline std::size_t GetVaruintSize(std::uint32_t value)
+{
+	std::size_t size = 1;
+	while (value >= 0x80)
+	{
+		value >>= 7;
+		size++;
+	}
+
+	return size;
+}
+
+inline void ByteWriter::UncheckedWrite(const void* data, std::size_t size)
+{
+	std::memcpy(&m_buffer[m_size], data, size);
+	m_size += size;
+}
+
+inline void ByteWriter::UncheckedWrite_u8(std::uint8_t value)
+{
+	m_buffer[m_size++] = value;
+}
+
+inline void ByteWriter::UncheckedWrite_u16(std::uint16_t value)
+{
+	// Les entiers sont crits en big endian (endianness rseau)
+	m_buffer[m_size++] = static_cast<std::uint8_t>(value >> 8);
+	m_buffer[m_size++] = static_cast<std::uint8_t>(value);
+}
+
+inline void ByteWriter::UncheckedWrite_u32(std::uint32_t value)
+{
+	m_buffer[m_size++] = static_cast<std::uint8_t>(value >> 24);
+	m_buffer[m_size++] = static_cast<std::uint8_t>(value >> 16);
+	m_buffer[m_size++] = static_cast<std::uint8_t>(value >> 8);
+	m_buffer[m_size++] = static_cast<std::uint8_t>(value);
+}
+
+inline void ByteWriter::UncheckedWrite_varuint(std::uint32_t value)
+{
+	while (value >= 0x80)
+	{
+		m_buffer[m_size++] = static_cast<std::uint8_t>(value | 0x80);
+		value >>= 7;
+	}
+
+	m_buffer[m_size++] = static_cast<std::uint8_t>(value);
+}
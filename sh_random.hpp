@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+
+// La classe RandomGenerator est un gnrateur pseudo-alatoire (PCG32) initialis  partir d'une graine.
+// Contrairement  rand() (tat global, RAND_MAX pouvant valoir 32767) ou aux distributions de la bibliothque standard
+// (dont l'algorithme dpend de l'implmentation), une mme graine donne exactement la mme suite de nombres sur toutes les plateformes,
+// ce qui permet de rejouer une partie  l'identique.
+class RandomGenerator
+{
+public:
+	explicit RandomGenerator(std::uint64_t seed);
+
+	// Renvoie un entier 32 bits uniformment rparti
+	std::uint32_t Generate();
+
+	// Renvoie un entier uniformment rparti entre zro et bound (exclu), bound ne devant pas tre nul
+	std::uint32_t GenerateBelow(std::uint32_t bound);
+
+private:
+	std::uint64_t m_state;
+};
+
+inline RandomGenerator::RandomGenerator(std::uint64_t seed) :
+m_state(0)
+{
+	Generate();
+	m_state += seed;
+	Generate();
+}
+
+inline std::uint32_t RandomGenerator::Generate()
+{
+	std::uint64_t oldState = m_state;
+	m_state = oldState * 6364136223846793005ULL + 1442695040888963407ULL;
+
+	std::uint32_t xorShifted = static_cast<std::uint32_t>(((oldState >> 18u) ^ oldState) >> 27u);
+	std::uint32_t rotation = static_cast<std::uint32_t>(oldState >> 59u);
+	return (xorShifted >> rotation) | (xorShifted << ((~rotation + 1u) & 31));
+}
+
+inline std::uint32_t RandomGenerator::GenerateBelow(std::uint32_t bound)
+{
+	// Les valeurs en dessous de threshold sont rejetes, sans quoi les plus petits rsultats seraient lgrement plus probables
+	std::uint32_t threshold = (~bound + 1u) % bound;
+	for (;;)
+	{
+		std::uint32_t value = Generate();
+		if (value >= threshold)
+			return value % bound;
+	}
+}
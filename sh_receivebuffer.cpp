@@ -0,0 +1,92 @@
+#include "sh_receivebuffer.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+ReceiveBuffer::ReceiveBuffer(std::size_t capacity) :
+m_buffer(std::max(capacity, MinWritableSize)),
+m_readOffset(0),
+m_writeOffset(0)
+{
+}
+
+void ReceiveBuffer::Commit(std::size_t size)
+{
+	assert(size <= GetWritableSize());
+	m_writeOffset += size;
+}
+
+std::size_t ReceiveBuffer::GetPendingSize() const
+{
+	return m_writeOffset - m_readOffset;
+}
+
+std::size_t ReceiveBuffer::GetWritableSize() const
+{
+	return m_buffer.size() - m_writeOffset;
+}
+
+bool ReceiveBuffer::HasError() const
+{
+	std::size_t headerSize;
+	std::size_t messageSize;
+	return PeekHeader(headerSize, messageSize) && messageSize > MaxMessageSize;
+}
+
+std::optional<ByteReader> ReceiveBuffer::PopMessage()
+{
+	std::size_t headerSize;
+	std::size_t messageSize;
+	if (!PeekHeader(headerSize, messageSize) || messageSize > MaxMessageSize)
+		return std::nullopt;
+
+	if (GetPendingSize() - headerSize < messageSize)
+		return std::nullopt;
+
+	ByteReader message(&m_buffer[m_readOffset + headerSize], messageSize);
+	m_readOffset += headerSize + messageSize;
+
+	return message;
+}
+
+std::uint8_t* ReceiveBuffer::PrepareWrite()
+{
+	std::size_t pendingSize = GetPendingSize();
+
+	// Tout a t trait, on peut repartir du dbut du buffer sans rien dplacer
+	if (pendingSize == 0)
+		m_readOffset = m_writeOffset = 0;
+
+	// Si on connat dj la taille du message en cours de rception, on s'assure qu'il pourra tenir entirement dans le buffer
+	std::size_t requiredSize = pendingSize + MinWritableSize;
+
+	std::size_t headerSize;
+	std::size_t messageSize;
+	if (PeekHeader(headerSize, messageSize) && messageSize <= MaxMessageSize)
+		requiredSize = std::max(requiredSize, headerSize + messageSize);
+
+	if (GetWritableSize() < MinWritableSize || m_buffer.size() - m_readOffset < requiredSize)
+	{
+		// On ne ramne les donnes restantes au dbut du buffer que lorsque la place manque  la fin de celui-ci
+		std::memmove(&m_buffer[0], &m_buffer[m_readOffset], pendingSize);
+		m_readOffset = 0;
+		m_writeOffset = pendingSize;
+
+		// Mme aprs compaction il n'y a pas assez de place, on agrandit le buffer
+		if (m_buffer.size() < requiredSize)
+			m_buffer.resize(std::max(requiredSize, m_buffer.size() * 2));
+	}
+
+	return &m_buffer[m_writeOffset];
+}
+
+bool ReceiveBuffer::PeekHeader(std::size_t& headerSize, std::size_t& messageSize) const
+{
+	ByteReader header(m_buffer.data() + m_readOffset, GetPendingSize());
+	messageSize = Unserialize_u16(header);
+	if (messageSize == ExtendedMessageSize)
+		messageSize = Unserialize_u32(header);
+
+	headerSize = header.GetOffset();
+	return !header.HasError();
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "sh_protocol.hpp"
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+// La classe ReceiveBuffer stocke les donnes reues sur une connexion et les dcoupe en messages, directement en place.
+// Elle utilise deux curseurs (lecture et criture) : retirer un message trait revient juste  avancer le curseur de lecture,
+// les donnes restantes ne sont ramenes au dbut du buffer que lorsque la place manque  la fin de celui-ci
+// (plutt que de dcaler tout le buffer  chaque message trait).
+//
+// Utilisation :
+//   recv(sock, buffer.PrepareWrite(), buffer.GetWritableSize(), 0) puis buffer.Commit(byteRead)
+//   puis while (auto message = buffer.PopMessage()) { ... }
+class ReceiveBuffer
+{
+public:
+	explicit ReceiveBuffer(std::size_t capacity = 4096);
+
+	// Valide l'criture de `size` octets (reus  l'adresse renvoye par PrepareWrite)
+	void Commit(std::size_t size);
+
+	// Renvoie le nombre d'octets reus mais pas encore traits
+	std::size_t GetPendingSize() const;
+
+	// Renvoie le nombre d'octets pouvant tre crits  l'adresse renvoye par PrepareWrite
+	std::size_t GetWritableSize() const;
+
+	// Indique si le message en cours de rception dpasse MaxMessageSize (il ne sera jamais renvoy par PopMessage, la connexion doit tre ferme)
+	bool HasError() const;
+
+	// Renvoie un reader sur le prochain message complet (sans sa taille) et le retire du buffer, ou std::nullopt s'il n'y en a pas.
+	// Le reader reste valide jusqu'au prochain appel  PrepareWrite
+	std::optional<ByteReader> PopMessage();
+
+	// Prpare la place pour une nouvelle rception (en compactant ou en agrandissant le buffer si ncessaire)
+	// et renvoie l'adresse  laquelle crire les donnes reues
+	std::uint8_t* PrepareWrite();
+
+	static constexpr std::size_t MaxMessageSize = 16 * 1024 * 1024;
+
+private:
+	static constexpr std::size_t MinWritableSize = 1024;
+
+	// Lit la taille du message en cours de rception (ainsi que celle de l'en-tte la contenant, qui peut tre tendu)
+	// renvoie false si l'en-tte n'a pas encore t entirement reu
+	bool PeekHeader(std::size_t& headerSize, std::size_t& messageSize) const;
+
+	std::vector<std::uint8_t> m_buffer;
+	std::size_t m_readOffset;
+	std::size_t m_writeOffset;
+};
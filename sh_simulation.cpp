@@ -0,0 +1,338 @@
+#include "sh_simulation.hpp"
+#include <algorithm>
+#include <cassert>
+#include <iterator>
+
+namespace
+{
+	// Direction indexe par SnakeDirection
+	const sf::Vector2i InputDirections[] = { { -1, 0 }, { 1, 0 }, { 0, -1 }, { 0, 1 } };
+}
+
+Simulation::Simulation(int width, int height, std::uint64_t seed, std::size_t threadCount) :
+m_freeCells(width, height),
+m_grid(width, height),
+m_occupancy(width, height),
+m_randomGenerator(seed),
+m_taskPool(threadCount),
+m_tickIndex(0)
+{
+	m_grid.SetupWalls();
+
+	// Aucun serpent n'est encore prsent, les cellules libres sont les cellules vides de la grille
+	for (int y = 0; y < m_grid.GetHeight(); ++y)
+	{
+		for (int x = m_grid.FindEmptyCellInRow(0, y); x >= 0; x = (x + 1 < m_grid.GetWidth()) ? m_grid.FindEmptyCellInRow(x + 1, y) : -1)
+			m_freeCells.Insert(sf::Vector2i(x, y));
+	}
+}
+
+const Snake& Simulation::AddSnake(unsigned int snakeId)
+{
+	assert(m_snakes.find(snakeId) == m_snakes.end());
+
+	SpawnPoint spawnPoint = FindSpawnPoint();
+
+	Color color;
+	color.r = static_cast<std::uint8_t>(m_randomGenerator.GenerateBelow(0xFF));
+	color.g = static_cast<std::uint8_t>(m_randomGenerator.GenerateBelow(0xFF));
+	color.b = static_cast<std::uint8_t>(m_randomGenerator.GenerateBelow(0xFF));
+
+	Snake& snake = m_snakes.try_emplace(snakeId, spawnPoint.position, spawnPoint.direction, color).first->second;
+	AddToOccupancy(snake);
+
+	SimulationEvent& event = m_events.emplace_back();
+	event.type = SimulationEventType::SnakeSpawned;
+	event.snakeId = snakeId;
+
+	return snake;
+}
+
+void Simulation::ClearEvents()
+{
+	m_events.clear();
+}
+
+const std::vector<SimulationEvent>& Simulation::GetEvents() const
+{
+	return m_events;
+}
+
+const Grid& Simulation::GetGrid() const
+{
+	return m_grid;
+}
+
+const Snake* Simulation::GetSnake(unsigned int snakeId) const
+{
+	auto it = m_snakes.find(snakeId);
+	return (it != m_snakes.end()) ? &it->second : nullptr;
+}
+
+const std::map<unsigned int, Snake>& Simulation::GetSnakes() const
+{
+	return m_snakes;
+}
+
+std::uint32_t Simulation::GetTickIndex() const
+{
+	return m_tickIndex;
+}
+
+void Simulation::RemoveSnake(unsigned int snakeId)
+{
+	auto it = m_snakes.find(snakeId);
+	assert(it != m_snakes.end());
+
+	RemoveFromOccupancy(it->second);
+	m_snakes.erase(it);
+	m_inputQueues.erase(snakeId);
+}
+
+bool Simulation::SpawnApple()
+{
+	// On tire la pomme parmi les cellules libres (ni pleine, ni occupe par un serpent), ce qui n'choue que si le terrain est plein
+	if (m_freeCells.IsEmpty())
+		return false;
+
+	sf::Vector2i applePos = m_freeCells.GetCell(m_randomGenerator.GenerateBelow(static_cast<std::uint32_t>(m_freeCells.GetSize())));
+	SetCell(applePos, CellType::Apple);
+
+	return true;
+}
+
+void Simulation::Tick(const std::vector<SnakeInput>& inputs)
+{
+	for (const SnakeInput& input : inputs)
+		QueueInput(input);
+
+	ApplyQueuedInputs();
+
+	// On fait d'abord avancer tous les serpents avant de rsoudre les collisions
+	for (auto& [snakeId, snake] : m_snakes)
+	{
+		// Seules la nouvelle tte et l'ancienne queue changent de cellule
+		sf::Vector2i tailPos = snake.GetBody().back();
+		snake.Advance();
+
+		m_occupancy.RemoveSegment(tailPos);
+		m_occupancy.AddSegment(snake.GetHeadPosition());
+
+		RefreshFreeCell(tailPos);
+		m_freeCells.Remove(snake.GetHeadPosition());
+	}
+
+	// On dtecte les collisions entre serpents (sur l'tat obtenu une fois tous les serpents avancs)
+	DetectSnakeCollisions();
+
+	// Puis on les rsout, ainsi que les collisions avec la grille
+	for (auto& [snakeId, snake] : m_snakes)
+	{
+		bool isDead = std::binary_search(m_collidedSnakes.begin(), m_collidedSnakes.end(), snakeId);
+
+		// On teste la collision de la tte du serpent avec la grille
+		sf::Vector2i headPos = snake.GetHeadPosition();
+		switch (m_grid.GetCell(headPos.x, headPos.y))
+		{
+			case CellType::Apple:
+			{
+				SetCell(headPos, CellType::None);
+
+				snake.Grow();
+				m_occupancy.AddSegment(snake.GetBody().back());
+				m_freeCells.Remove(snake.GetBody().back());
+
+				SimulationEvent& event = m_events.emplace_back();
+				event.type = SimulationEventType::SnakeGrew;
+				event.snakeId = snakeId;
+				break;
+			}
+
+			case CellType::Wall:
+			{
+				// Le serpent s'est pris un mur
+				SimulationEvent& event = m_events.emplace_back();
+				event.type = SimulationEventType::SnakeHitWall;
+				event.snakeId = snakeId;
+
+				isDead = true;
+				break;
+			}
+
+			case CellType::None:
+			default:
+				break;
+		}
+
+		// Le serpent s'est pris un mur, un autre serpent ou lui-mme, on le fait rapparaitre
+		if (isDead)
+			RespawnSnake(snakeId, snake);
+	}
+
+	m_tickIndex++;
+}
+
+void Simulation::AddToOccupancy(const Snake& snake)
+{
+	// Le serpent occupe dsormais ses cellules, qui ne sont donc plus libres
+	m_occupancy.AddSnake(snake);
+	for (const sf::Vector2i& position : snake.GetBody())
+		m_freeCells.Remove(position);
+}
+
+void Simulation::ApplyQueuedInputs()
+{
+	// Seuls les serpents ayant des directions en attente sont parcourus (dans l'ordre de leur identifiant)
+	for (auto it = m_inputQueues.begin(); it != m_inputQueues.end();)
+	{
+		Snake& snake = m_snakes.at(it->first);
+		std::vector<QueuedInput>& queue = it->second;
+
+		// Une seule direction est applique par tick, les suivantes attendront les ticks suivants
+		// (une direction trop ancienne, ou faisant faire demi-tour au serpent, est ignore sans consommer le tick)
+		std::size_t consumedCount = 0;
+		while (consumedCount < queue.size())
+		{
+			const QueuedInput& input = queue[consumedCount++];
+			if (m_tickIndex - input.tick > MaxInputAge)
+				continue;
+
+			const sf::Vector2i& direction = InputDirections[static_cast<std::size_t>(input.direction)];
+			if (direction == -snake.GetCurrentDirection())
+				continue;
+
+			snake.SetFollowingDirection(direction);
+			break;
+		}
+
+		queue.erase(queue.begin(), queue.begin() + consumedCount);
+
+		if (queue.empty())
+			it = m_inputQueues.erase(it);
+		else
+			++it;
+	}
+}
+
+void Simulation::DetectSnakeCollisions()
+{
+	m_collidedSnakes.clear();
+
+	// La carte d'occupation indique en une lecture par tte si celle-ci est entre en collision avec un serpent :
+	// la plupart du temps aucune collision n'a lieu, et il est inutile de chercher qui a percut qui
+	bool hasCollision = false;
+	for (const auto& [snakeId, snake] : m_snakes)
+	{
+		if (m_occupancy.GetCount(snake.GetHeadPosition()) > 1)
+		{
+			hasCollision = true;
+			break;
+		}
+	}
+
+	if (!hasCollision)
+		return;
+
+	// Toutes les collisions sont dtectes avant que le moindre serpent ne rapparaisse,
+	// une collision tte contre tte touche donc les deux serpents quel que soit leur ordre
+	m_broadphase.Clear();
+	for (const auto& [snakeId, snake] : m_snakes)
+		m_broadphase.AddSnake(snakeId, snake);
+
+	// La dtection est rpartie entre les threads de la simulation s'il y en a plusieurs (sinon elle parcourt tous les serpents d'un bloc),
+	// les collisions tant tries elle ne dpend pas de cette rpartition
+	m_broadphase.Detect(m_collisions, (m_taskPool.GetThreadCount() > 1) ? &m_taskPool : nullptr);
+
+	for (const SnakeCollision& collision : m_collisions)
+	{
+		SimulationEvent& event = m_events.emplace_back();
+		event.type = SimulationEventType::SnakeCollided;
+		event.snakeId = collision.snakeId;
+		event.otherId = collision.otherId;
+		event.collisionType = collision.type;
+
+		// Les collisions sont tries par serpent
+		if (m_collidedSnakes.empty() || m_collidedSnakes.back() != collision.snakeId)
+			m_collidedSnakes.push_back(collision.snakeId);
+	}
+}
+
+SpawnPoint Simulation::FindSpawnPoint()
+{
+	// Chaque serpent apparat  un endroit libre, plutt que tous au centre du terrain (o ils se rentreraient dedans)
+	if (std::optional<SpawnPoint> spawnPoint = ::FindSpawnPoint(m_freeCells, m_randomGenerator, SpawnHeadroom))
+		return *spawnPoint;
+
+	// Le terrain est trop encombr, le serpent apparat au centre (et ressaiera s'il y meurt)
+	return SpawnPoint{ sf::Vector2i(m_grid.GetWidth() / 2, m_grid.GetHeight() / 2), sf::Vector2i(1, 0) };
+}
+
+void Simulation::QueueInput(const SnakeInput& input)
+{
+	// Le serpent a pu disparatre depuis l'envoi de l'entre, et le joueur ne peut pas avoir vu un tat qui n'existe pas encore
+	auto it = m_snakes.find(input.snakeId);
+	if (it == m_snakes.end() || input.tick > m_tickIndex)
+		return;
+
+	std::size_t directionIndex = static_cast<std::size_t>(input.direction);
+	assert(directionIndex < std::size(InputDirections));
+
+	std::vector<QueuedInput>& queue = m_inputQueues[input.snakeId];
+	if (queue.size() >= MaxQueuedInputs)
+		return;
+
+	// Une direction identique  la prcdente (ou  celle que suit dj le serpent) ne changerait rien
+	sf::Vector2i previousDirection = (queue.empty()) ? it->second.GetFollowingDirection() : InputDirections[static_cast<std::size_t>(queue.back().direction)];
+	if (InputDirections[directionIndex] == previousDirection)
+	{
+		if (queue.empty())
+			m_inputQueues.erase(input.snakeId);
+
+		return;
+	}
+
+	queue.push_back({ input.direction, input.tick });
+}
+
+void Simulation::RefreshFreeCell(const sf::Vector2i& position)
+{
+	bool isFree = m_grid.GetCell(position.x, position.y) == CellType::None && !m_occupancy.IsOccupied(position);
+	m_freeCells.Update(position, isFree);
+}
+
+void Simulation::RemoveFromOccupancy(const Snake& snake)
+{
+	// Les cellules quittes par le serpent redeviennent libres (si aucun autre serpent ou lment de la grille ne s'y trouve)
+	m_occupancy.RemoveSnake(snake);
+	for (const sf::Vector2i& position : snake.GetBody())
+		RefreshFreeCell(position);
+}
+
+void Simulation::RespawnSnake(unsigned int snakeId, Snake& snake)
+{
+	// On retire le serpent de la carte d'occupation avant de le dplacer, puis on l'y remet
+	// (les directions en attente concernaient le serpent avant sa mort, elles sont abandonnes)
+	RemoveFromOccupancy(snake);
+	m_inputQueues.erase(snakeId);
+
+	SpawnPoint spawnPoint = FindSpawnPoint();
+	snake.Respawn(spawnPoint.position, spawnPoint.direction);
+	AddToOccupancy(snake);
+
+	SimulationEvent& event = m_events.emplace_back();
+	event.type = SimulationEventType::SnakeSpawned;
+	event.snakeId = snakeId;
+}
+
+void Simulation::SetCell(const sf::Vector2i& position, CellType cellType)
+{
+	if (m_grid.GetCell(position.x, position.y) == cellType)
+		return;
+
+	m_grid.SetCell(position.x, position.y, cellType);
+	RefreshFreeCell(position);
+
+	SimulationEvent& event = m_events.emplace_back();
+	event.type = SimulationEventType::CellChanged;
+	event.position = position;
+}
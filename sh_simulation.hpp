@@ -0,0 +1,122 @@
+#pragma once
+
+#include "sh_broadphase.hpp"
+#include "sh_constants.hpp"
+#include "sh_freecellset.hpp"
+#include "sh_grid.hpp"
+#include "sh_occupancy.hpp"
+#include "sh_random.hpp"
+#include "sh_snake.hpp"
+#include "sh_spawn.hpp"
+#include "sh_taskpool.hpp"
+#include <SFML/System/Vector2.hpp>
+#include <cstdint>
+#include <map>
+#include <vector>
+
+// Ce qui s'est produit pendant la simulation (et que le serveur doit par exemple transmettre aux joueurs)
+enum class SimulationEventType
+{
+	CellChanged, //< le contenu d'une cellule de la grille a chang (position)
+	SnakeCollided, //< la tte d'un serpent est entre en collision avec un serpent (snakeId, otherId, collisionType)
+	SnakeGrew, //< un serpent a mang une pomme et grandi (snakeId)
+	SnakeHitWall, //< la tte d'un serpent est entre dans un mur (snakeId)
+	SnakeSpawned //< un serpent est apparu ou rapparu (snakeId)
+};
+
+struct SimulationEvent
+{
+	SimulationEventType type;
+	unsigned int snakeId = 0;
+	unsigned int otherId = 0;
+	CollisionType collisionType = CollisionType::Body;
+	sf::Vector2i position;
+};
+
+// Direction demande par un joueur pour son serpent : les directions d'un mme serpent sont mises en file et appliques dans l'ordre,
+// une par tick (deux appuis rapprochs entre deux ticks donnent ainsi un virage serr plutt que seulement la dernire direction)
+struct SnakeInput
+{
+	unsigned int snakeId;
+	SnakeDirection direction;
+	std::uint32_t tick; //< dernier tick connu du joueur lorsqu'il a choisi cette direction (voir GetTickIndex)
+};
+
+// La classe Simulation contient toutes les rgles du jeu (dplacement des serpents, collisions, pommes, rapparitions)
+// indpendamment du rseau et de l'affichage : elle reoit les entres des joueurs et produit un nouvel tat ainsi qu'une liste
+// d'vnements. Tout l'alatoire provient d'un gnrateur initialis par une graine, et les serpents sont toujours parcourus
+// dans l'ordre de leur identifiant : une mme graine et les mmes entres donnent donc toujours la mme partie.
+//
+// Pour les trs grandes parties, la dtection des collisions (qui ne fait que lire l'tat) peut tre rpartie entre plusieurs threads,
+// leur rsolution restant squentielle : le rsultat est identique quel que soit le nombre de threads.
+class Simulation
+{
+public:
+	// threadCount est le nombre de threads (thread appelant compris) utiliss pendant un tick pour la dtection des collisions
+	Simulation(int width, int height, std::uint64_t seed, std::size_t threadCount = 1);
+
+	// Ajoute un serpent (d'identifiant unique)  un endroit libre du terrain
+	const Snake& AddSnake(unsigned int snakeId);
+
+	// Vide la liste des vnements ( appeler une fois ceux-ci traits)
+	void ClearEvents();
+
+	const std::vector<SimulationEvent>& GetEvents() const;
+	const Grid& GetGrid() const;
+
+	// Renvoie le serpent correspondant  un identifiant, ou nullptr s'il n'existe pas
+	const Snake* GetSnake(unsigned int snakeId) const;
+
+	// Serpents indexs par leur identifiant (les rfrences restent valides jusqu'au retrait du serpent)
+	const std::map<unsigned int, Snake>& GetSnakes() const;
+
+	// Nombre de ticks excuts depuis le dbut de la partie, qui identifie l'tat courant (et auquel font rfrence les entres des joueurs)
+	std::uint32_t GetTickIndex() const;
+
+	// Retire un serpent du terrain
+	void RemoveSnake(unsigned int snakeId);
+
+	// Fait apparatre une pomme sur une cellule libre tire au hasard, renvoie false si le terrain est plein
+	bool SpawnApple();
+
+	// Fait avancer la simulation d'un tick : les entres des joueurs sont ajoutes (dans l'ordre)  la file de leur serpent,
+	// puis chaque serpent applique la plus ancienne direction de sa file
+	void Tick(const std::vector<SnakeInput>& inputs);
+
+	// Nombre maximum de directions en attente par serpent (au-del, les nouvelles directions sont ignores)
+	static constexpr std::size_t MaxQueuedInputs = 3;
+	// ge maximum (en ticks) d'une direction au moment de l'appliquer : au-del, le joueur l'a choisie en voyant un tat trop ancien
+	static constexpr std::uint32_t MaxInputAge = 4;
+	// Nombre de cellules devant tre libres devant la tte d'un serpent  son apparition
+	static constexpr unsigned int SpawnHeadroom = 4;
+
+private:
+	struct QueuedInput
+	{
+		SnakeDirection direction;
+		std::uint32_t tick;
+	};
+
+	void AddToOccupancy(const Snake& snake);
+	void ApplyQueuedInputs();
+	void DetectSnakeCollisions();
+	SpawnPoint FindSpawnPoint();
+	void QueueInput(const SnakeInput& input);
+	void RefreshFreeCell(const sf::Vector2i& position);
+	void RemoveFromOccupancy(const Snake& snake);
+	void RespawnSnake(unsigned int snakeId, Snake& snake);
+	void SetCell(const sf::Vector2i& position, CellType cellType);
+
+	std::map<unsigned int, Snake> m_snakes;
+	std::map<unsigned int, std::vector<QueuedInput>> m_inputQueues; //< directions en attente des serpents en ayant, la plus ancienne en premier
+	std::vector<unsigned int> m_collidedSnakes; //< serpents entrs en collision avec un serpent pendant le tick en cours
+	std::vector<SnakeCollision> m_collisions;
+	std::vector<SimulationEvent> m_events;
+	CollisionBroadphase m_broadphase;
+	FreeCellSet m_freeCells; //< cellules ni occupes par la grille ni par un serpent, tenues  jour en mme temps que ceux-ci
+	Grid m_grid;
+	OccupancyGrid m_occupancy; //< position des serpents, tenue  jour  chaque modification de ceux-ci
+	RandomGenerator m_randomGenerator;
+	TaskPool m_taskPool;
+	std::uint32_t m_tickIndex;
+};
@@ -2,9 +2,95 @@
 #include "sh_constants.hpp"
 #include <cassert>
 
+namespace
+{
+	const std::size_t InitialBodyCapacity = 16;
+}
+
+SnakeBody::Iterator::Iterator(const SnakeBody& body, std::size_t index) :
+m_body(&body),
+m_index(index)
+{
+}
+
+auto SnakeBody::Iterator::operator*() const -> reference
+{
+	return (*m_body)[m_index];
+}
+
+auto SnakeBody::Iterator::operator->() const -> pointer
+{
+	return &(*m_body)[m_index];
+}
+
+auto SnakeBody::Iterator::operator++() -> Iterator&
+{
+	++m_index;
+	return *this;
+}
+
+auto SnakeBody::Iterator::operator++(int) -> Iterator
+{
+	Iterator it = *this;
+	++m_index;
+	return it;
+}
+
+bool SnakeBody::Iterator::operator==(const Iterator& other) const
+{
+	return m_body == other.m_body && m_index == other.m_index;
+}
+
+bool SnakeBody::Iterator::operator!=(const Iterator& other) const
+{
+	return !operator==(other);
+}
+
+SnakeBody::SnakeBody(const sf::Vector2i* data, std::size_t mask, std::size_t headIndex, std::size_t length) :
+m_data(data),
+m_headIndex(headIndex),
+m_length(length),
+m_mask(mask)
+{
+}
+
+auto SnakeBody::begin() const -> Iterator
+{
+	return Iterator(*this, 0);
+}
+
+auto SnakeBody::end() const -> Iterator
+{
+	return Iterator(*this, m_length);
+}
+
+const sf::Vector2i& SnakeBody::back() const
+{
+	return operator[](m_length - 1);
+}
+
+const sf::Vector2i& SnakeBody::front() const
+{
+	return operator[](0);
+}
+
+std::size_t SnakeBody::size() const
+{
+	return m_length;
+}
+
+const sf::Vector2i& SnakeBody::operator[](std::size_t index) const
+{
+	assert(index < m_length);
+	return m_data[(m_headIndex + index) & m_mask];
+}
+
+
 Snake::Snake(const sf::Vector2i& spawnPosition, const sf::Vector2i& direction, const Color& color) :
 m_color(color),
-m_followingDir(direction)
+m_followingDir(direction),
+m_headIndex(0),
+m_length(0)
 {
 	Respawn(spawnPosition, direction);
 }
@@ -12,24 +98,25 @@ m_followingDir(direction)
 Snake::Snake(std::vector<sf::Vector2i> body, const sf::Vector2i& followingDirection, const Color& color) :
 m_color(color),
 m_followingDir(followingDirection),
-m_body(std::move(body))
+m_headIndex(0),
+m_length(0)
 {
+	SetBody(body);
 }
 
 void Snake::Advance()
 {
-	for (std::size_t i = m_body.size() - 1; i != 0; i--)
-	{
-		auto& pos = m_body[i];
-		pos = m_body[i - 1];
-	}
+	std::size_t mask = m_body.size() - 1;
+	std::size_t newHeadIndex = (m_headIndex + mask) & mask; //< quivalent  (m_headIndex - 1) modulo la capacit
 
-	m_body[0] += m_followingDir;
+	// La nouvelle tte crase l'ancienne queue, qui est la seule pice  disparatre
+	m_body[newHeadIndex] = m_body[m_headIndex] + m_followingDir;
+	m_headIndex = newHeadIndex;
 }
 
-const std::vector<sf::Vector2i>& Snake::GetBody() const
+SnakeBody Snake::GetBody() const
 {
-	return m_body;
+	return SnakeBody(m_body.data(), m_body.size() - 1, m_headIndex, m_length);
 }
 
 const Color& Snake::GetColor() const
@@ -39,7 +126,8 @@ const Color& Snake::GetColor() const
 
 sf::Vector2i Snake::GetCurrentDirection() const
 {
-	return m_body[0] - m_body[1];
+	SnakeBody body = GetBody();
+	return body[0] - body[1];
 }
 
 sf::Vector2i Snake::GetFollowingDirection() const
@@ -49,30 +137,65 @@ sf::Vector2i Snake::GetFollowingDirection() const
 
 sf::Vector2i Snake::GetHeadPosition() const
 {
-	return m_body[0];
+	return m_body[m_headIndex];
 }
 
 void Snake::Grow()
 {
-	std::size_t lastPartIndex = m_body.size() - 1;
-	sf::Vector2i lastPartDirection = m_body[lastPartIndex] - m_body[lastPartIndex - 1];
+	if (m_length == m_body.size())
+		Reserve(m_body.size() * 2);
+
+	SnakeBody body = GetBody();
+	sf::Vector2i lastPartDirection = body[m_length - 1] - body[m_length - 2];
+	sf::Vector2i newPart = body[m_length - 1] + lastPartDirection;
+
+	m_body[(m_headIndex + m_length) & (m_body.size() - 1)] = newPart;
+	m_length++;
+}
+
+void Snake::Reserve(std::size_t capacity)
+{
+	std::size_t newCapacity = (m_body.empty()) ? InitialBodyCapacity : m_body.size();
+	while (newCapacity < capacity)
+		newCapacity *= 2;
 
-	m_body.push_back(m_body.back() + lastPartDirection);
+	if (newCapacity == m_body.size())
+		return;
+
+	std::vector<sf::Vector2i> newBody(newCapacity);
+	if (!m_body.empty())
+	{
+		SnakeBody body = GetBody();
+		for (std::size_t i = 0; i < m_length; ++i)
+			newBody[i] = body[i];
+	}
+
+	m_body = std::move(newBody);
+	m_headIndex = 0;
 }
 
 void Snake::Respawn(const sf::Vector2i& spawnPosition, const sf::Vector2i& direction)
 {
-	m_body.clear();
-	m_body.push_back(spawnPosition);
-	m_body.push_back(spawnPosition - direction);
-	m_body.push_back(spawnPosition - direction * 2);
+	// On garde le buffer dj allou, seuls les index sont remis  zro
+	Reserve(3);
+
+	m_headIndex = 0;
+	m_length = 3;
+	m_body[0] = spawnPosition;
+	m_body[1] = spawnPosition - direction;
+	m_body[2] = spawnPosition - direction * 2;
 	m_followingDir = direction;
 }
 
 void Snake::SetBody(const std::vector<sf::Vector2i>& body)
 {
 	assert(body.size() >= 3);
-	m_body = body;
+	Reserve(body.size());
+
+	m_headIndex = 0;
+	m_length = body.size();
+	for (std::size_t i = 0; i < body.size(); ++i)
+		m_body[i] = body[i];
 }
 
 void Snake::SetFollowingDirection(const sf::Vector2i& direction)
@@ -83,9 +206,10 @@ void Snake::SetFollowingDirection(const sf::Vector2i& direction)
 
 bool Snake::TestCollision(const sf::Vector2i& position, bool testHead)
 {
-	for (std::size_t i = (testHead) ? 0 : 1; i < m_body.size(); ++i)
+	SnakeBody body = GetBody();
+	for (std::size_t i = (testHead) ? 0 : 1; i < body.size(); ++i)
 	{
-		if (m_body[i] == position)
+		if (body[i] == position)
 			return true;
 	}
 
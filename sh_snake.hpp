@@ -2,8 +2,57 @@
 
 #include "sh_color.hpp"
 #include <SFML/System/Vector2.hpp>
+#include <cstddef>
+#include <iterator>
 #include <vector>
 
+// Vue (non-propritaire) sur le corps d'un serpent, celui-ci tant stock dans un buffer circulaire
+// les positions sont parcourues de la tte (index 0) jusqu' la queue
+class SnakeBody
+{
+public:
+	class Iterator
+	{
+	public:
+		using iterator_category = std::forward_iterator_tag;
+		using value_type = sf::Vector2i;
+		using difference_type = std::ptrdiff_t;
+		using pointer = const sf::Vector2i*;
+		using reference = const sf::Vector2i&;
+
+		Iterator(const SnakeBody& body, std::size_t index);
+
+		reference operator*() const;
+		pointer operator->() const;
+		Iterator& operator++();
+		Iterator operator++(int);
+
+		bool operator==(const Iterator& other) const;
+		bool operator!=(const Iterator& other) const;
+
+	private:
+		const SnakeBody* m_body;
+		std::size_t m_index;
+	};
+
+	SnakeBody(const sf::Vector2i* data, std::size_t mask, std::size_t headIndex, std::size_t length);
+
+	Iterator begin() const;
+	Iterator end() const;
+
+	const sf::Vector2i& back() const;
+	const sf::Vector2i& front() const;
+	std::size_t size() const;
+
+	const sf::Vector2i& operator[](std::size_t index) const;
+
+private:
+	const sf::Vector2i* m_data;
+	std::size_t m_headIndex;
+	std::size_t m_length;
+	std::size_t m_mask;
+};
+
 // La classe Snake reprsente un serpent en jeu, ainsi que toutes ses pices
 // celui-ci possde toujours une taille de trois  l'apparition, et peut grandir,
 // se dplacer dans une direction prcise, et rapparaitre en remettant sa taille  zro
@@ -17,8 +66,8 @@ public:
 	// Fait avancer le serpent dans la direction suivie
 	void Advance();
 
-	// Retourne la liste des positions occupes par le serpent
-	const std::vector<sf::Vector2i>& GetBody() const;
+	// Retourne une vue sur les positions occupes par le serpent (invalide par Grow, Respawn et SetBody)
+	SnakeBody GetBody() const;
 
 	// Rcupre la couleur du serpent
 	const Color& GetColor() const;
@@ -49,7 +98,14 @@ public:
 	bool TestCollision(const sf::Vector2i& position, bool testHead);
 
 protected:
+	// Agrandit le buffer circulaire (en remettant la tte  l'index zro) pour qu'il puisse contenir au moins `capacity` pices
+	void Reserve(std::size_t capacity);
+
 	Color m_color;
 	sf::Vector2i m_followingDir;
-	std::vector<sf::Vector2i> m_body; //< doit au moins avoir trois lments quoiqu'il arrive
+	// Le corps est stock dans un buffer circulaire dont la taille est une puissance de deux,
+	// ce qui permet d'avancer en O(1) en dplaant simplement l'index de la tte plutt que de dcaler toutes les pices
+	std::vector<sf::Vector2i> m_body;
+	std::size_t m_headIndex;
+	std::size_t m_length; //< doit au moins valoir trois quoiqu'il arrive
 };
@@ -0,0 +1,62 @@
+#pragma once
+
+// Ce fichier regroupe les en-ttes rseau propres  chaque plateforme
+// Sous Windows on utilise Winsock, sous Linux on utilise les sockets POSIX en reprenant les noms de Winsock
+// (SOCKET, closesocket, WSAGetLastError, ...) pour que le reste du code n'ait pas  faire la diffrence
+
+#ifdef _WIN32
+
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+
+#include <winsock2.h> //< Header principal de Winsock
+#include <ws2tcpip.h> //< Header pour le modle TCP/IP, permettant notamment la gestion d'adresses IP
+
+#else
+
+#include <arpa/inet.h> //< htons, inet_ntop, ...
+#include <cerrno> //< errno
+#include <fcntl.h> //< fcntl
+#include <netinet/in.h> //< sockaddr_in
+#include <netinet/tcp.h> //< TCP_NODELAY
+#include <sys/socket.h> //< socket, bind, listen, accept, send, recv
+#include <unistd.h> //< close
+
+using SOCKET = int;
+
+constexpr SOCKET INVALID_SOCKET = -1;
+constexpr int SOCKET_ERROR = -1;
+constexpr int WSAEWOULDBLOCK = EWOULDBLOCK;
+
+inline int closesocket(SOCKET sock)
+{
+	return close(sock);
+}
+
+inline int WSAGetLastError()
+{
+	return errno;
+}
+
+#endif
+
+// Passe une socket en mode bloquant ou non-bloquant, renvoie false en cas d'erreur
+inline bool SetSocketBlocking(SOCKET sock, bool blocking)
+{
+#ifdef _WIN32
+	u_long noBlocking = (blocking) ? 0 : 1;
+	return ioctlsocket(sock, FIONBIO, &noBlocking) != SOCKET_ERROR;
+#else
+	int flags = fcntl(sock, F_GETFL, 0);
+	if (flags == -1)
+		return false;
+
+	flags = (blocking) ? (flags & ~O_NONBLOCK) : (flags | O_NONBLOCK);
+	return fcntl(sock, F_SETFL, flags) != -1;
+#endif
+}
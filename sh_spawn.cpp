@@ -0,0 +1,61 @@
+#include "sh_spawn.hpp"
+
+namespace
+{
+	// Taille d'un serpent  son apparition (voir Snake::Respawn)
+	constexpr int SpawnLength = 3;
+	// Nombre de cellules libres tires au hasard avant d'abandonner la recherche
+	constexpr unsigned int SpawnAttempts = 32;
+
+	const sf::Vector2i SpawnDirections[] = { { -1, 0 }, { 1, 0 }, { 0, -1 }, { 0, 1 } };
+}
+
+std::optional<SpawnPoint> FindSpawnPoint(const FreeCellSet& freeCells, RandomGenerator& randomGenerator, unsigned int headroom)
+{
+	if (freeCells.IsEmpty())
+		return std::nullopt;
+
+	std::optional<SpawnPoint> bestSpawn;
+	unsigned int bestHeadroom = 0;
+	for (unsigned int attempt = 0; attempt < SpawnAttempts; ++attempt)
+	{
+		// La cellule tire est libre, c'est la tte du serpent
+		sf::Vector2i position = freeCells.GetCell(randomGenerator.GenerateBelow(static_cast<std::uint32_t>(freeCells.GetSize())));
+
+		// On teste les quatre directions en partant d'une direction au hasard, pour ne pas en favoriser une
+		std::uint32_t firstDirection = randomGenerator.GenerateBelow(4);
+		for (int i = 0; i < 4; ++i)
+		{
+			const sf::Vector2i& direction = SpawnDirections[(firstDirection + i) % 4];
+
+			// Le reste du corps s'tend derrire la tte
+			bool bodyFits = true;
+			for (int j = 1; j < SpawnLength && bodyFits; ++j)
+				bodyFits = freeCells.IsInside(position - direction * j) && freeCells.Contains(position - direction * j);
+
+			if (!bodyFits)
+				continue;
+
+			unsigned int freeAhead = 0;
+			while (freeAhead < headroom)
+			{
+				sf::Vector2i aheadPos = position + direction * static_cast<int>(freeAhead + 1);
+				if (!freeCells.IsInside(aheadPos) || !freeCells.Contains(aheadPos))
+					break;
+
+				freeAhead++;
+			}
+
+			if (freeAhead == headroom)
+				return SpawnPoint{ position, direction };
+
+			if (!bestSpawn || freeAhead > bestHeadroom)
+			{
+				bestSpawn = SpawnPoint{ position, direction };
+				bestHeadroom = freeAhead;
+			}
+		}
+	}
+
+	return bestSpawn;
+}
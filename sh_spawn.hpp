@@ -0,0 +1,19 @@
+#pragma once
+
+#include "sh_freecellset.hpp"
+#include "sh_random.hpp"
+#include <SFML/System/Vector2.hpp>
+#include <optional>
+
+// Position et direction d'apparition d'un serpent
+struct SpawnPoint
+{
+	sf::Vector2i position; //< position de la tte
+	sf::Vector2i direction; //< direction suivie, le corps s'tendant dans la direction oppose
+};
+
+// Cherche un endroit o faire apparatre un serpent : les cellules de son corps doivent tre libres, ainsi que les `headroom` cellules
+// devant sa tte (pour qu'il ne meure pas ds son apparition). Les candidats sont tirs au hasard parmi les cellules libres,
+// ce qui cote un nombre born de tests quel que soit le nombre de serpents.
+// Si aucun candidat ne dispose de toute la marge demande, celui qui en a le plus est renvoy (std::nullopt si aucun corps ne rentre)
+std::optional<SpawnPoint> FindSpawnPoint(const FreeCellSet& freeCells, RandomGenerator& randomGenerator, unsigned int headroom);
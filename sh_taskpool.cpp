@@ -0,0 +1,97 @@
+#include "sh_taskpool.hpp"
+
+TaskPool::TaskPool(std::size_t threadCount) :
+m_task(nullptr),
+m_batchIndex(0),
+m_nextTask(0),
+m_remainingTasks(0),
+m_taskCount(0),
+m_stopRequested(false)
+{
+	// Le thread appelant compte parmi les threads du pool
+	for (std::size_t i = 1; i < threadCount; ++i)
+		m_threads.emplace_back(&TaskPool::WorkerMain, this);
+}
+
+TaskPool::~TaskPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stopRequested = true;
+	}
+	m_startCondition.notify_all();
+
+	for (std::thread& thread : m_threads)
+		thread.join();
+}
+
+std::size_t TaskPool::GetThreadCount() const
+{
+	return m_threads.size() + 1;
+}
+
+void TaskPool::Run(std::size_t taskCount, const std::function<void(std::size_t taskIndex)>& task)
+{
+	// Inutile de rveiller les threads pour une seule tche
+	if (m_threads.empty() || taskCount <= 1)
+	{
+		for (std::size_t i = 0; i < taskCount; ++i)
+			task(i);
+
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_task = &task;
+		m_taskCount = taskCount;
+		m_nextTask = 0;
+		m_remainingTasks = taskCount;
+		m_batchIndex++;
+	}
+	m_startCondition.notify_all();
+
+	RunTasks();
+
+	// Les autres threads peuvent encore tre en train de terminer leur dernire tche
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_doneCondition.wait(lock, [&] { return m_remainingTasks == 0; });
+	m_task = nullptr;
+}
+
+void TaskPool::RunTasks()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+
+	// Chaque thread prend la tche suivante jusqu' puisement du lot (un thread rveill aprs la fin du lot n'en trouve donc aucune)
+	while (m_nextTask < m_taskCount)
+	{
+		std::size_t taskIndex = m_nextTask++;
+		const std::function<void(std::size_t)>& task = *m_task;
+
+		lock.unlock();
+		task(taskIndex);
+		lock.lock();
+
+		if (--m_remainingTasks == 0)
+			m_doneCondition.notify_all();
+	}
+}
+
+void TaskPool::WorkerMain()
+{
+	std::size_t lastBatchIndex = 0;
+	for (;;)
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_startCondition.wait(lock, [&] { return m_stopRequested || m_batchIndex != lastBatchIndex; });
+			if (m_stopRequested)
+				return;
+
+			lastBatchIndex = m_batchIndex;
+		}
+
+		RunTasks();
+	}
+}
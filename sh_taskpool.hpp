@@ -0,0 +1,42 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// La classe TaskPool rpartit un lot de tches indpendantes (des plages de serpents par exemple) entre des threads crs une fois
+// pour toutes, le thread appelant participant lui aussi au traitement : Run ne rend la main qu'une fois toutes les tches termines.
+// Les tches sont distribues dans un ordre quelconque, leur rsultat ne doit donc dpendre ni de cet ordre ni du thread qui les excute.
+class TaskPool
+{
+public:
+	// Le nombre de threads inclut le thread appelant (un pool d'un seul thread excute donc toutes les tches sur place)
+	explicit TaskPool(std::size_t threadCount);
+	TaskPool(const TaskPool&) = delete;
+	~TaskPool();
+
+	std::size_t GetThreadCount() const;
+
+	// Excute task(0)  task(taskCount - 1), rparties entre les threads
+	void Run(std::size_t taskCount, const std::function<void(std::size_t taskIndex)>& task);
+
+	TaskPool& operator=(const TaskPool&) = delete;
+
+private:
+	void RunTasks();
+	void WorkerMain();
+
+	std::condition_variable m_doneCondition; //< signale lorsque la dernire tche du lot est termine
+	std::condition_variable m_startCondition; //< signale lorsqu'un nouveau lot est disponible (ou  la destruction du pool)
+	std::mutex m_mutex; //< protge tous les membres suivants
+	std::vector<std::thread> m_threads;
+	const std::function<void(std::size_t)>* m_task;
+	std::size_t m_batchIndex; //< incrment  chaque lot, pour qu'un thread ne se rveille qu'une fois par lot
+	std::size_t m_nextTask;
+	std::size_t m_remainingTasks;
+	std::size_t m_taskCount;
+	bool m_stopRequested;
+};
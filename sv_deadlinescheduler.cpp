@@ -0,0 +1,138 @@
+﻿#include "sv_deadlinescheduler.hpp"
+#include <algorithm>
+
+DeadlineScheduler::DeadlineScheduler(std::size_t queueCount, const sf::Time& stealDelay) :
+m_queues(queueCount),
+m_stealDelay(stealDelay)
+{
+}
+
+void DeadlineScheduler::Advance(std::size_t queueIndex, unsigned int taskId, const sf::Time& deadline)
+{
+	Queue& queue = m_queues[queueIndex];
+
+	std::lock_guard<std::mutex> lock(queue.mutex);
+	auto taskIt = std::find_if(queue.tasks.begin(), queue.tasks.end(), [&](const Task& task) { return task.taskId == taskId; });
+	if (taskIt != queue.tasks.end())
+	{
+		if (deadline < taskIt->deadline)
+		{
+			taskIt->deadline = deadline;
+			std::make_heap(queue.tasks.begin(), queue.tasks.end(), &DeadlineScheduler::Compare);
+		}
+
+		return;
+	}
+
+	auto advanceIt = std::find_if(queue.advances.begin(), queue.advances.end(), [&](const Task& task) { return task.taskId == taskId; });
+	if (advanceIt == queue.advances.end())
+		queue.advances.push_back({ deadline, taskId });
+	else
+		advanceIt->deadline = std::min(advanceIt->deadline, deadline);
+}
+
+int DeadlineScheduler::GetTimeout(std::size_t queueIndex, const sf::Time& now) const
+{
+	std::optional<sf::Time> nextDeadline;
+	for (std::size_t i = 0; i < m_queues.size(); ++i)
+	{
+		std::optional<sf::Time> deadline = GetFrontDeadline(m_queues[i]);
+		if (!deadline)
+			continue;
+
+		// Les tâches des autres threads ne nous concernent que s'ils ne les ont pas exécutées à temps
+		if (i != queueIndex)
+			*deadline += m_stealDelay;
+
+		if (!nextDeadline || *deadline < *nextDeadline)
+			nextDeadline = deadline;
+	}
+
+	if (!nextDeadline)
+		return -1;
+
+	sf::Int64 remaining = (*nextDeadline - now).asMicroseconds();
+	if (remaining <= 0)
+		return 0;
+
+	return static_cast<int>((remaining + 999) / 1000);
+}
+
+std::optional<DeadlineScheduler::Task> DeadlineScheduler::PopDue(std::size_t queueIndex, const sf::Time& now)
+{
+	// Les tâches de notre propre file sont prioritaires
+	if (std::optional<Task> task = PopFront(m_queues[queueIndex], now))
+		return task;
+
+	// Sinon on cherche la tâche la plus en retard des autres files
+	for (;;)
+	{
+		std::size_t victimIndex = m_queues.size();
+		sf::Time victimDeadline;
+		for (std::size_t i = 0; i < m_queues.size(); ++i)
+		{
+			if (i == queueIndex)
+				continue;
+
+			std::optional<sf::Time> deadline = GetFrontDeadline(m_queues[i]);
+			if (deadline && *deadline + m_stealDelay <= now && (victimIndex == m_queues.size() || *deadline < victimDeadline))
+			{
+				victimIndex = i;
+				victimDeadline = *deadline;
+			}
+		}
+
+		if (victimIndex == m_queues.size())
+			return std::nullopt;
+
+		// La tâche a pu être prise entre-temps (par son thread ou par un autre voleur), auquel cas on recommence
+		if (std::optional<Task> task = PopFront(m_queues[victimIndex], now - m_stealDelay))
+			return task;
+	}
+}
+
+void DeadlineScheduler::Schedule(std::size_t queueIndex, unsigned int taskId, const sf::Time& deadline)
+{
+	Queue& queue = m_queues[queueIndex];
+
+	std::lock_guard<std::mutex> lock(queue.mutex);
+	queue.tasks.push_back({ deadline, taskId });
+
+	// La tâche a pu être avancée pendant son exécution
+	auto advanceIt = std::find_if(queue.advances.begin(), queue.advances.end(), [&](const Task& task) { return task.taskId == taskId; });
+	if (advanceIt != queue.advances.end())
+	{
+		queue.tasks.back().deadline = std::min(deadline, advanceIt->deadline);
+		queue.advances.erase(advanceIt);
+	}
+
+	std::push_heap(queue.tasks.begin(), queue.tasks.end(), &DeadlineScheduler::Compare);
+}
+
+bool DeadlineScheduler::Compare(const Task& lhs, const Task& rhs)
+{
+	// std::push_heap construit un tas dont le sommet est le plus grand élément, on inverse donc la comparaison
+	return lhs.deadline > rhs.deadline;
+}
+
+std::optional<sf::Time> DeadlineScheduler::GetFrontDeadline(const Queue& queue)
+{
+	std::lock_guard<std::mutex> lock(queue.mutex);
+	if (queue.tasks.empty())
+		return std::nullopt;
+
+	return queue.tasks.front().deadline;
+}
+
+std::optional<DeadlineScheduler::Task> DeadlineScheduler::PopFront(Queue& queue, const sf::Time& maxDeadline)
+{
+	std::lock_guard<std::mutex> lock(queue.mutex);
+	if (queue.tasks.empty() || queue.tasks.front().deadline > maxDeadline)
+		return std::nullopt;
+
+	std::pop_heap(queue.tasks.begin(), queue.tasks.end(), &DeadlineScheduler::Compare);
+	Task task = queue.tasks.back();
+	queue.tasks.pop_back();
+
+	return task;
+}
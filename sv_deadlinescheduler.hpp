@@ -0,0 +1,58 @@
+﻿#pragma once
+
+#include <SFML/System/Time.hpp>
+#include <cstddef>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+// La classe DeadlineScheduler répartit des tâches datées entre plusieurs files, une par thread
+// (typiquement le prochain tick de chaque salle, dans la file du thread auquel appartient la salle).
+// Un thread exécute en priorité les tâches échues de sa propre file, la plus en retard d'abord. S'il n'en a aucune, il vole
+// la tâche la plus en retard des autres files, pour peu qu'elle soit échue depuis au moins stealDelay (ce qui laisse à son thread
+// l'occasion de l'exécuter lui-même) : une salle chargée ne retarde ainsi pas les autres salles de son thread tant que d'autres threads sont libres.
+//
+// Toutes les fonctions peuvent être appelées depuis n'importe quel thread, chaque file étant protégée par son propre mutex.
+class DeadlineScheduler
+{
+public:
+	struct Task
+	{
+		sf::Time deadline;
+		unsigned int taskId;
+	};
+
+	DeadlineScheduler(std::size_t queueCount, const sf::Time& stealDelay);
+	DeadlineScheduler(const DeadlineScheduler&) = delete;
+
+	// Rapproche l'échéance d'une tâche programmée dans une file (sans effet si elle est déjà plus proche).
+	// Si la tâche n'y est pas (en cours d'exécution), c'est sa prochaine programmation dans cette file qui sera avancée
+	void Advance(std::size_t queueIndex, unsigned int taskId, const sf::Time& deadline);
+
+	// Renvoie le nombre de millisecondes (arrondi au supérieur) avant la prochaine échéance concernant un thread, ou -1 s'il n'y en a aucune :
+	// celles de sa file, ainsi que celles des autres files augmentées de stealDelay
+	int GetTimeout(std::size_t queueIndex, const sf::Time& now) const;
+
+	// Retire et renvoie la tâche échue que le thread doit exécuter (de sa file, ou volée à une autre), ou rien si aucune ne l'est
+	std::optional<Task> PopDue(std::size_t queueIndex, const sf::Time& now);
+
+	// Programme une tâche dans une file
+	void Schedule(std::size_t queueIndex, unsigned int taskId, const sf::Time& deadline);
+
+	DeadlineScheduler& operator=(const DeadlineScheduler&) = delete;
+
+private:
+	struct Queue
+	{
+		mutable std::mutex mutex;
+		std::vector<Task> tasks; //< tas dont le sommet est la tâche à l'échéance la plus proche
+		std::vector<Task> advances; //< échéances demandées pour des tâches absentes du tas, appliquées à leur prochaine programmation
+	};
+
+	static bool Compare(const Task& lhs, const Task& rhs);
+	static std::optional<sf::Time> GetFrontDeadline(const Queue& queue);
+	static std::optional<Task> PopFront(Queue& queue, const sf::Time& maxDeadline);
+
+	std::vector<Queue> m_queues;
+	sf::Time m_stealDelay;
+};
@@ -0,0 +1,72 @@
+﻿#include "sv_histogram.hpp"
+#include <algorithm>
+
+Histogram::Histogram()
+{
+	Reset();
+}
+
+std::uint64_t Histogram::GetCount() const
+{
+	return m_count;
+}
+
+sf::Time Histogram::GetMax() const
+{
+	return sf::microseconds(m_max);
+}
+
+sf::Time Histogram::GetPercentile(float percentile) const
+{
+	if (m_count == 0)
+		return sf::Time::Zero;
+
+	std::uint64_t threshold = static_cast<std::uint64_t>(m_count * percentile / 100.f);
+	std::uint64_t accumulated = 0;
+	for (std::size_t i = 0; i < BucketCount; ++i)
+	{
+		accumulated += m_buckets[i];
+		if (accumulated > threshold || accumulated == m_count)
+			return std::min(GetBucketUpperBound(i), GetMax());
+	}
+
+	return GetMax();
+}
+
+void Histogram::Record(const sf::Time& duration)
+{
+	sf::Int64 value = std::max<sf::Int64>(duration.asMicroseconds(), 0);
+
+	// L'intervalle i contient les durées de [2^i, 2^(i+1)[ microsecondes (et l'intervalle zéro contient aussi zéro)
+	std::size_t bucketIndex = 0;
+	while (bucketIndex < BucketCount - 1 && (value >> (bucketIndex + 1)) != 0)
+		bucketIndex++;
+
+	m_buckets[bucketIndex]++;
+	m_count++;
+	m_max = std::max(m_max, value);
+}
+
+void Histogram::Reset()
+{
+	m_buckets.fill(0);
+	m_count = 0;
+	m_max = 0;
+}
+
+void Histogram::Print(std::ostream& stream) const
+{
+	stream << m_count << " samples, p50 <= " << GetPercentile(50.f).asMicroseconds() << "us, p99 <= " << GetPercentile(99.f).asMicroseconds() << "us, max = " << m_max << "us\n";
+	for (std::size_t i = 0; i < BucketCount; ++i)
+	{
+		if (m_buckets[i] == 0)
+			continue;
+
+		stream << "  < " << GetBucketUpperBound(i).asMicroseconds() << "us: " << m_buckets[i] << "\n";
+	}
+}
+
+sf::Time Histogram::GetBucketUpperBound(std::size_t bucketIndex)
+{
+	return sf::microseconds(sf::Int64(2) << bucketIndex);
+}
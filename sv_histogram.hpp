@@ -0,0 +1,41 @@
+﻿#pragma once
+
+#include <SFML/System/Time.hpp>
+#include <array>
+#include <cstdint>
+#include <ostream>
+
+// La classe Histogram compte des durées dans des intervalles de taille croissante (puissances de deux en microsecondes),
+// ce qui permet d'estimer des percentiles avec une mémoire fixe et un coût constant par mesure
+class Histogram
+{
+public:
+	Histogram();
+
+	// Renvoie le nombre de mesures enregistrées
+	std::uint64_t GetCount() const;
+
+	// Renvoie la plus grande mesure enregistrée
+	sf::Time GetMax() const;
+
+	// Renvoie une borne supérieure de la durée en dessous de laquelle se trouvent `percentile` % des mesures
+	sf::Time GetPercentile(float percentile) const;
+
+	// Enregistre une mesure (les durées négatives sont comptées comme nulles)
+	void Record(const sf::Time& duration);
+
+	// Efface toutes les mesures
+	void Reset();
+
+	// Affiche un résumé de l'histogramme (nombre de mesures, percentiles et intervalles non-vides)
+	void Print(std::ostream& stream) const;
+
+private:
+	static constexpr std::size_t BucketCount = 32;
+
+	static sf::Time GetBucketUpperBound(std::size_t bucketIndex);
+
+	std::array<std::uint64_t, BucketCount> m_buckets;
+	std::uint64_t m_count;
+	sf::Int64 m_max;
+};
@@ -1,22 +1,35 @@
-﻿#define WIN32_LEAN_AND_MEAN
-#define NOMINMAX
-
-#include "sh_constants.hpp"
-#include "sh_grid.hpp"
-#include "sh_snake.hpp"
+﻿#include "sh_constants.hpp"
 #include "sh_protocol.hpp"
+#include "sh_receivebuffer.hpp"
+#include "sh_simulation.hpp" //< Règles du jeu
+#include "sh_socket.hpp" //< Headers réseau (Winsock sous Windows, sockets POSIX sous Linux)
+#include "sv_deadlinescheduler.hpp" //< Répartition des ticks des salles entre les threads
+#include "sv_histogram.hpp" //< Mesure de la régularité des ticks
+#include "sv_outboundqueue.hpp" //< Files d'envoi des joueurs
+#include "sv_poller.hpp" //< Surveillance des sockets (WSAPoll sous Windows, epoll sous Linux)
+#include "sv_spscqueue.hpp" //< Files sans verrou entre les salles et les threads d'entrées/sorties
+#include "sv_tickscheduler.hpp" //< Pas de temps fixe et rattrapage des ticks en retard
+#include "sv_timerqueue.hpp" //< Échéances (ticks, apparition des pommes, ...)
 #include <SFML/System/Clock.hpp> //< Gestion du temps avec la SFML
+#include <algorithm> //< std::find_if
+#include <atomic> //< std::atomic
 #include <cassert> //< assert
+#include <chrono> //< std::chrono::milliseconds
+#include <condition_variable> //< std::condition_variable
+#include <cstring> //< std::memcpy
 #include <iostream> //< std::cout/std::cerr
+#include <memory> //< std::unique_ptr
+#include <mutex> //< std::mutex
 #include <optional>
+#include <random> //< std::random_device
+#include <sstream> //< std::ostringstream
 #include <string> //< std::string / std::string_view
 #include <thread> //< std::thread
 #include <vector> //< std::vector
-#include <winsock2.h> //< Header principal de Winsock
-#include <ws2tcpip.h> //< Header pour le modèle TCP/IP, permettant notamment la gestion d'adresses IP
 
 // Sous Windows il faut linker ws2_32.lib (Propriétés du projet => Éditeur de lien => Entrée => Dépendances supplémentaires)
 // Ce projet est également configuré en C++17 (ce n'est pas nécessaire à winsock)
+// Sous Linux le serveur n'a besoin d'aucune bibliothèque réseau supplémentaire
 
 /*
 //////
@@ -24,48 +37,248 @@ Squelette d'un serveur de Snake
 //////
 */
 
-struct Player
+struct GameState;
+
+// Partie réseau d'un joueur, manipulée uniquement par le thread d'entrées/sorties de sa salle (ou par le lobby avant qu'il ne la rejoigne)
+struct Connection
 {
 	SOCKET socket;
 	unsigned int id;
-	std::vector<std::uint8_t> pendingData;
-	std::optional<Snake> snake;
+	GameState* gameState = nullptr; //< salle rejointe par le joueur (nullptr tant qu'il est dans le lobby), seules ses files sont utilisées
+	OutboundQueue outboundQueue; //< paquets en attente d'envoi
+	ReceiveBuffer receiveBuffer; //< données reçues mais pas encore traitées
+	std::optional<sf::Time> congestedSince; //< moment depuis lequel la file d'envoi dépasse le seuil haut
+	bool awaitingKeyframe = true; //< les deltas sont abandonnés jusqu'au prochain état complet (le client n'a pas l'état auquel ils s'appliquent)
+	bool helloReceived = false; //< la version du protocole du joueur a été acceptée, il peut choisir une salle
+	bool isReady = false; //< la salle a accueilli le joueur (S_Welcome), il reçoit désormais les paquets destinés à toute la salle
+	bool waitingWritable = false; //< la socket est pleine, on attend qu'elle soit à nouveau disponible en écriture
+};
+
+// Partie simulation d'un joueur, manipulée uniquement par le thread exécutant les ticks de sa salle
+struct Player
+{
+	unsigned int id;
+	const Snake* snake = nullptr; //< serpent du joueur, appartenant à la simulation
+	unsigned int kills = 0; //< nombre de serpents s'étant pris le corps de celui du joueur (pour un futur tableau des scores)
+	bool needsKeyframe = true; //< le joueur doit recevoir l'état complet des serpents au prochain tick
+	bool snakeGrew = false; //< le serpent a grandi pendant le tick en cours
+	bool snakeReset = false; //< le serpent est apparu ou réapparu depuis le dernier état envoyé
+};
+
+// Événement transmis à une salle par son thread d'entrées/sorties
+enum class RoomEventType : std::uint8_t
+{
+	DirectionChanged, //< le joueur a demandé une nouvelle direction (direction)
+	KeyframeNeeded, //< un delta n'a pas pu être envoyé au joueur, il doit recevoir l'état complet des serpents
+	PlayerJoined, //< le joueur est arrivé dans la salle
+	PlayerLeft //< le joueur s'est déconnecté
+};
+
+struct RoomEvent
+{
+	unsigned int playerId;
+	RoomEventType type;
+	SnakeDirection direction = SnakeDirection::Left;
+	std::uint32_t tick = 0; //< tick du dernier état reçu par le joueur lorsqu'il a choisi la direction
+};
+
+// Nature d'un paquet produit par une salle, qui indique à son thread d'entrées/sorties comment le mettre en file d'envoi
+enum class RoomPacketType : std::uint8_t
+{
+	Delta, //< modifications des serpents depuis l'état précédent (abandonné si celui-ci n'a pas encore été envoyé)
+	Keyframe, //< état complet des serpents, remplaçant celui qui n'aurait pas encore été envoyé
+	Reliable, //< paquet devant être reçu tel quel (grille, ...)
+	Welcome, //< premier paquet envoyé au joueur, qui reçoit ensuite les paquets destinés à toute la salle
+	Report, //< texte à afficher sur la sortie standard (statistiques de la salle), aucun joueur ne le reçoit
+	Warning //< texte à afficher sur la sortie d'erreur (surcharge de la salle), aucun joueur ne le reçoit
+};
+
+// Destinataire d'un paquet envoyé à tous les joueurs de la salle (les identifiants des joueurs commencent à 1)
+constexpr unsigned int AllPlayers = 0;
+
+struct RoomPacket
+{
+	SharedPacket packet;
+	unsigned int playerId = AllPlayers;
+	RoomPacketType type = RoomPacketType::Reliable;
+	std::string text; //< rapport déjà formaté (Report/Warning), affiché d'un bloc par le thread d'entrées/sorties
 };
 
+// État d'une salle (une partie indépendante des autres). Ses ticks peuvent être exécutés par n'importe quel thread de simulation,
+// mais jamais par deux à la fois (voir DeadlineScheduler) : la salle ne communique avec le thread d'entrées/sorties de ses joueurs
+// qu'au travers de deux files sans verrou, un tick n'attend donc jamais de verrou et ne fait aucun appel système
 struct GameState
 {
-	GameState() :
-	grid(GridWidth, GridHeight)
+	GameState(unsigned int roomId, const sf::Clock& serverClock) :
+	id(roomId),
+	clock(serverClock),
+	tickScheduler(sf::seconds(TickDelay), MaxCatchUpTicks),
+	events(EventQueueSize),
+	packets(PacketQueueSize),
+	simulation(GridWidth, GridHeight, std::random_device{}())
 	{
-		grid.SetupWalls();
-
-		nextAppleSpawn = appleSpawnInterval;
-		nextTick = tickInterval;
 	}
 
-	sf::Clock clock;
+	// Nombre de ticks entre deux envois de l'état complet des serpents à tous les joueurs (les autres ticks n'envoient que les modifications)
+	static constexpr unsigned int KeyframeInterval = 20;
+	// Nombre maximum de ticks en retard rattrapés d'un coup, au-delà ils sont abandonnés (et comptabilisés)
+	static constexpr unsigned int MaxCatchUpTicks = 4;
+	// Capacité des files entre la salle et son thread d'entrées/sorties (au-delà, les éléments attendent leur tour dans un backlog)
+	static constexpr std::size_t EventQueueSize = 1024;
+	static constexpr std::size_t PacketQueueSize = 256;
+
+	unsigned int id; //< identifiant de la salle (à partir de 1)
+	std::atomic<unsigned int> playerCount{ 0 }; //< joueurs de la salle, y compris ceux en cours de transfert depuis le lobby (lu par celui-ci)
+	const sf::Clock& clock; //< horloge commune à toutes les salles, pour que leurs échéances soient comparables
 	sf::Time appleSpawnInterval = sf::seconds(4.f);
-	sf::Time tickInterval = sf::seconds(TickDelay);
+	sf::Time statsInterval = sf::seconds(60.f);
 	sf::Time nextAppleSpawn;
-	sf::Time nextTick;
-	std::vector<Player> players;
-	Grid grid;
+	unsigned int ticksSinceKeyframe = 0;
+	TickScheduler tickScheduler;
+	TimerQueue timers; //< échéances de la salle (ticks, apparition des pommes, ...)
+	Histogram tickJitter; //< retard de chaque tick par rapport à son échéance, affiché toutes les statsInterval
+	std::vector<std::unique_ptr<Player>> players;
+	std::vector<unsigned int> removedSnakes; //< serpents disparus depuis le dernier état envoyé
+	std::vector<sf::Vector2i> dirtyCells; //< cellules de la grille modifiées depuis le dernier état envoyé
+	std::vector<SnakeInput> pendingInputs; //< directions demandées par les joueurs, appliquées au prochain tick
+	std::vector<RoomPacket> packetBacklog; //< paquets n'ayant pas trouvé de place dans la file, à envoyer avant les suivants (côté salle)
+	std::vector<RoomEvent> eventBacklog; //< événements n'ayant pas trouvé de place dans la file, à envoyer avant les suivants (côté entrées/sorties)
+	bool packetsPushed = false; //< des paquets ont été ajoutés à la file depuis la fin de la dernière exécution de la salle (côté salle)
+	bool isAppleTimerArmed = false; //< les pommes apparaissent (côté salle, voir schedule_game_timers)
+	bool isTickTimerArmed = false; //< le jeu est mis à jour (côté salle, voir schedule_game_timers)
+	std::atomic<bool> isSleeping{ true }; //< la salle n'a plus de joueur et ne programme plus de tick, elle doit être réveillée à l'arrivée du prochain (voir wake_room)
+	SpscQueue<RoomEvent> events; //< du thread d'entrées/sorties vers la salle
+	SpscQueue<RoomPacket> packets; //< de la salle vers le thread d'entrées/sorties
+	Simulation simulation;
+};
+
+// Un thread de simulation exécute les ticks des salles qui lui appartiennent, ainsi que ceux des salles des autres threads
+// lorsque ceux-ci sont trop occupés (voir DeadlineScheduler). Il ne manipule aucune socket.
+struct Worker
+{
+	std::size_t index; //< file du thread dans le planificateur des salles
+	std::vector<std::unique_ptr<GameState>> rooms;
+	std::thread thread;
+};
+
+// Un thread d'entrées/sorties possède les sockets des joueurs d'un ensemble de salles : il transforme leurs messages
+// en événements pour leur salle, et met en file d'envoi les paquets produits par celle-ci
+struct IoThread
+{
+	explicit IoThread(const sf::Clock& serverClock) :
+	clock(serverClock)
+	{
+	}
+
+	const sf::Clock& clock;
+	// Un client ne recevant pas assez vite ses données est exclu lorsque sa file d'envoi dépasse outboundHardLimit,
+	// ou lorsqu'elle reste au-delà de outboundHighWaterMark pendant plus de slowClientTimeout
+	std::size_t outboundHighWaterMark = 16 * 1024;
+	std::size_t outboundHardLimit = 256 * 1024;
+	sf::Time slowClientTimeout = sf::seconds(5.f);
+	std::mutex inboxMutex;
+	std::vector<std::unique_ptr<Connection>> inbox; //< joueurs confiés par le lobby, pas encore pris en charge par le thread (protégé par inboxMutex)
+	std::vector<std::unique_ptr<Connection>> connections;
+	std::vector<Connection*> connectionsToEvict; //< joueurs trop lents, déconnectés à la fin du tour de boucle
+	std::vector<Connection*> connectionsToFlush; //< joueurs ayant de nouveaux paquets en attente d'envoi
+	std::vector<GameState*> rooms; //< salles dont le thread gère les joueurs
+	std::thread thread;
+	std::atomic<bool> sleeping{ false }; //< le thread attend (ou s'apprête à attendre) ses sockets, une salle produisant des paquets doit le réveiller
+	Poller poller; //< sockets des joueurs des salles du thread
+};
+
+// Le lobby (le thread principal) accepte les connexions, négocie la version du protocole
+// puis confie chaque joueur au thread d'entrées/sorties de la salle qu'il a choisie
+struct Lobby
+{
+	explicit Lobby(std::size_t workerCount) :
+	roomScheduler(workerCount, sf::milliseconds(1))
+	{
+	}
+
+	// Nombre de salles hébergées par le serveur, et nombre maximum de joueurs par salle
+	static constexpr unsigned int RoomCount = 16;
+	static constexpr unsigned int MaxPlayersPerRoom = 16;
+	// Nombre de threads de simulation par thread d'entrées/sorties (ces derniers ne font que des copies et des appels système)
+	static constexpr unsigned int WorkersPerIoThread = 4;
+
+	sf::Clock clock;
+	// Prochaine échéance de chaque salle, dans la file du thread auquel elle appartient : un thread libre exécute les ticks
+	// en retard des autres threads (au-delà d'une milliseconde de retard, pour que le thread de la salle ait l'occasion de s'en charger)
+	DeadlineScheduler roomScheduler;
+
+	std::atomic<bool> stopRequested{ false }; //< une erreur fatale s'est produite, tous les threads doivent s'arrêter
+	std::mutex stopMutex;
+	std::condition_variable stopCondition; //< réveille les threads de simulation en attente de leur prochaine échéance lors de l'arrêt ou du réveil d'une salle
+	std::atomic<unsigned int> roomWakeups{ 0 }; //< nombre de salles réveillées par les threads d'entrées/sorties (modifié sous stopMutex)
+	unsigned int nextClientId = 1;
+	std::vector<std::unique_ptr<Connection>> connections; //< joueurs connectés n'ayant pas encore rejoint de salle
+	std::vector<GameState*> rooms; //< toutes les salles (appartenant à leur thread), indexées par identifiant - 1
+	std::vector<std::unique_ptr<IoThread>> ioThreads;
+	std::vector<std::unique_ptr<Worker>> workers;
+	Poller poller; //< socket serveur et sockets des joueurs du lobby
 };
 
 // On déclare un prototype des fonctions que nous allons définir plus tard
 // (en C++ avant d'appeler une fonction il faut dire au compilateur qu'elle existe, quitte à la définir après)
 int server(SOCKET sock);
-void broadcast_grid_update(GameState& gameState, int cellX, int cellY);
-void handle_message(Player& client, const std::vector<std::uint8_t>& message, std::size_t offset, GameState& gameState);
+bool accept_clients(Lobby& lobby, SOCKET sock);
+void adopt_connections(Lobby& lobby, IoThread& ioThread);
+void broadcast_grid_update(GameState& gameState);
+SharedPacket build_game_state(GameState& gameState);
+SharedPacket build_game_state_delta(GameState& gameState);
+void disconnect_connection(IoThread& ioThread, Connection& connection);
+void disconnect_lobby_connection(Lobby& lobby, Connection& connection);
+void dispatch_room_packet(IoThread& ioThread, GameState& gameState, const RoomPacket& roomPacket);
+Player* find_player(GameState& gameState, unsigned int playerId);
+void flush_connections(IoThread& ioThread);
+void flush_event_backlog(GameState& gameState);
+void flush_packet_backlog(GameState& gameState);
+int get_io_thread_timeout(IoThread& ioThread);
+IoThread& get_room_io_thread(Lobby& lobby, unsigned int roomId);
+Worker& get_room_worker(Lobby& lobby, unsigned int roomId);
+void hand_over_connection(Lobby& lobby, Connection& connection);
+bool handle_lobby_message(Lobby& lobby, Connection& connection, ByteReader& message);
+bool handle_message(Connection& connection, ByteReader& message);
+bool process_messages(Connection& connection);
+void process_room_events(GameState& gameState);
+void process_room_timers(Lobby& lobby, GameState& gameState);
+void process_simulation_events(GameState& gameState);
+void push_room_event(GameState& gameState, const RoomEvent& event);
+void push_room_packet(GameState& gameState, RoomPacket roomPacket);
+void push_room_packet(GameState& gameState, unsigned int playerId, SharedPacket packet, RoomPacketType type);
+void push_room_report(GameState& gameState, RoomPacketType type, std::string text);
+bool put_room_to_sleep(GameState& gameState);
+void queue_packet(IoThread& ioThread, Connection& connection, SharedPacket packet, bool replaceable = false);
+bool read_socket(Connection& connection, bool& wouldBlock);
+bool receive_data(Connection& connection);
+bool receive_lobby_data(Lobby& lobby, Connection& connection);
+void remove_player(GameState& gameState, unsigned int playerId);
+void run_io_thread(Lobby& lobby, IoThread& ioThread);
+int run_lobby(Lobby& lobby, SOCKET sock);
+void run_worker(Lobby& lobby, Worker& worker);
+GameState* select_room(Lobby& lobby, std::uint32_t roomId);
+bool send_data(IoThread& ioThread, Connection& connection);
+void send_game_state(GameState& gameState);
+void schedule_game_timers(GameState& gameState);
+void schedule_timers(GameState& gameState);
 void send_grid(GameState& gameState, Player& player);
-void tick(GameState& gameState, const sf::Time& now);
+void serialize_snake(ByteWriter& packet, const Snake& snake);
+bool spawn_apple(GameState& gameState);
+void stop_threads(Lobby& lobby);
+void tick(GameState& gameState);
+void wake_io_thread(IoThread& ioThread);
+void wake_room(Lobby& lobby, GameState& gameState);
+void welcome_player(GameState& gameState, unsigned int playerId);
 
 int main()
 {
+#ifdef _WIN32
 	// Initialisation de Winsock en version 2.2
 	// Cette opération est obligatoire sous Windows avant d'utiliser les sockets
 	WSADATA data;
 	WSAStartup(MAKEWORD(2, 2), &data); //< MAKEWORD compose un entier 16bits à partir de deux entiers 8bits utilisés par WSAStartup pour connaître la version à initialiser
+#endif
 
 	// La création d'une socket se fait à l'aide de la fonction `socket`, celle-ci prend la famille de sockets, le type de socket,
 	// ainsi que le protocole désiré (0 est possible en troisième paramètre pour laisser le choix du protocole à la fonction).
@@ -81,7 +294,7 @@ int main()
 		return EXIT_FAILURE;
 	}
 
-	BOOL option = 1;
+	int option = 1;
 	if (setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&option), sizeof(option)) == SOCKET_ERROR)
 	{
 		std::cerr << "failed to disable Naggle's algorithm (" << WSAGetLastError() << ")\n";
@@ -93,8 +306,10 @@ int main()
 	// Comme dans le premier code, on n'oublie pas de fermer les sockets dès qu'on en a plus besoin
 	closesocket(sock);
 
+#ifdef _WIN32
 	// Et on arrête l'application réseau également.
 	WSACleanup();
+#endif
 
 	return r; //< On retourne le code d'erreur de la fonction server / client
 }
@@ -123,410 +338,1302 @@ int server(SOCKET sock)
 		return EXIT_FAILURE;
 	}
 
-	// On définit une structure pour représenter une liste de client (avec un identifiant numérique)
-	unsigned int nextClientId = 1;
+	// La socket serveur est passée en mode non-bloquant, ce qui permet d'accepter tous les clients en attente
+	// jusqu'à ce que accept nous indique qu'il n'y en a plus (WSAEWOULDBLOCK)
+	if (!SetSocketBlocking(sock, false))
+	{
+		std::cerr << "failed to set socket blocking mode (" << WSAGetLastError() << ")\n";
+		return EXIT_FAILURE;
+	}
 
-	GameState gameState;
+	// Un processus héberge plusieurs salles, réparties entre autant de threads de simulation que de coeurs
+	// (chaque salle appartient toujours au même thread, qui peut néanmoins se faire aider pour les ticks)
+	// les sockets des joueurs sont gérées à part, par des threads d'entrées/sorties moins nombreux
+	unsigned int workerCount = std::clamp(std::thread::hardware_concurrency(), 1u, Lobby::RoomCount);
+	unsigned int ioThreadCount = std::max(workerCount / Lobby::WorkersPerIoThread, 1u);
+
+	// Le poller nous permet de surveiller plusieurs sockets simultanément (epoll sous Linux, WSAPoll sous Windows).
+	// Plutôt que de reconstruire la liste des sockets à chaque tour de boucle, on enregistre chaque socket une seule fois,
+	// avec un pointeur vers le joueur correspondant (la socket serveur n'a pas de pointeur associé).
+	// Le lobby et chaque thread d'entrées/sorties ont leur propre poller, surveillant leurs propres joueurs.
+	Lobby lobby(workerCount);
+	if (!lobby.poller.IsValid() || !lobby.poller.Register(sock, nullptr))
+	{
+		std::cerr << "failed to initialize poller (" << WSAGetLastError() << ")\n";
+		return EXIT_FAILURE;
+	}
 
-	// Boucle infinie pour continuer d'accepter des clients
+	for (unsigned int i = 0; i < ioThreadCount; ++i)
+	{
+		IoThread& ioThread = *lobby.ioThreads.emplace_back(std::make_unique<IoThread>(lobby.clock));
+		if (!ioThread.poller.IsValid())
+		{
+			std::cerr << "failed to initialize poller (" << WSAGetLastError() << ")\n";
+			return EXIT_FAILURE;
+		}
+	}
+
+	for (unsigned int i = 0; i < workerCount; ++i)
+	{
+		Worker& worker = *lobby.workers.emplace_back(std::make_unique<Worker>());
+		worker.index = i;
+	}
+
+	for (unsigned int roomId = 1; roomId <= Lobby::RoomCount; ++roomId)
+	{
+		Worker& worker = get_room_worker(lobby, roomId);
+
+		GameState& room = *worker.rooms.emplace_back(std::make_unique<GameState>(roomId, lobby.clock));
+		schedule_timers(room);
+
+		lobby.roomScheduler.Schedule(worker.index, roomId, *room.timers.GetNextDeadline());
+		lobby.rooms.push_back(&room);
+
+		get_room_io_thread(lobby, roomId).rooms.push_back(&room);
+	}
+
+	for (auto& ioThreadPtr : lobby.ioThreads)
+		ioThreadPtr->thread = std::thread(run_io_thread, std::ref(lobby), std::ref(*ioThreadPtr));
+
+	for (auto& workerPtr : lobby.workers)
+		workerPtr->thread = std::thread(run_worker, std::ref(lobby), std::ref(*workerPtr));
+
+	std::cout << "hosting " << Lobby::RoomCount << " rooms on " << workerCount << " simulation thread(s) and " << ioThreadCount << " I/O thread(s)" << std::endl;
+
+	int result = run_lobby(lobby, sock);
+
+	// On n'arrive ici qu'en cas d'erreur, les threads doivent être arrêtés avant de détruire leurs salles
+	stop_threads(lobby);
+
+	return result;
+}
+
+bool accept_clients(Lobby& lobby, SOCKET sock)
+{
 	for (;;)
 	{
-		// On construit une liste de descripteurs pour la fonctions WSAPoll, qui nous permet de surveiller plusieurs sockets simultanément
-		// Ces descripteurs référencent les sockets à surveiller ainsi que les événements à écouter (le plus souvent on surveillera l'entrée,
-		// à l'aide de POLLRDNORM). Ceci va détecter les données reçues en entrée par nos sockets, mais aussi les événements de déconnexion.
-		// Dans le cas de la socket serveur, cela permet aussi de savoir lorsqu'un client est en attente d'acceptation (et donc que l'appel à accept ne va pas bloquer).
+		sockaddr_in clientAddr;
+		socklen_t clientAddrSize = sizeof(clientAddr);
 
-		// Note: on pourrait ne pas reconstruire le tableau à chaque fois, si vous voulez le faire en exercice ;o
-		std::vector<WSAPOLLFD> pollDescriptors;
+		SOCKET newClient = accept(sock, reinterpret_cast<sockaddr*>(&clientAddr), &clientAddrSize);
+		if (newClient == INVALID_SOCKET)
 		{
-			// La méthode emplace_back construit un objet à l'intérieur du vector et nous renvoie une référence dessus
-			// alternativement nous pourrions également construire une variable de type WSAPOLLFD et l'ajouter au vector avec push_back 
-			auto& serverDescriptor = pollDescriptors.emplace_back();
-			serverDescriptor.fd = sock;
-			serverDescriptor.events = POLLRDNORM;
-			serverDescriptor.revents = 0;
+			// Plus aucun client en attente
+			if (WSAGetLastError() == WSAEWOULDBLOCK)
+				return true;
+
+			std::cerr << "failed to accept new client (" << WSAGetLastError() << ")\n";
+			return false;
 		}
 
-		// On rajoute un descripteur pour chacun de nos clients actuels
-		for (Player& client : gameState.players)
+		// Les sockets clientes sont non-bloquantes : un client ne recevant pas ses données ne doit pas bloquer le serveur
+		// (sous Windows la socket acceptée hérite du mode de la socket serveur, ce qui n'est pas le cas sous Linux)
+		if (!SetSocketBlocking(newClient, false))
 		{
-			auto& clientDescriptor = pollDescriptors.emplace_back();
-			clientDescriptor.fd = client.socket;
-			clientDescriptor.events = POLLRDNORM;
-			clientDescriptor.revents = 0;
+			std::cerr << "failed to set client socket blocking mode (" << WSAGetLastError() << ")\n";
+			closesocket(newClient);
+			continue;
 		}
 
-		// On appelle la fonction WSAPoll (équivalent poll sous Linux) pour bloquer jusqu'à ce qu'un événement se produise
-		// au niveau d'une de nos sockets. Cette fonction attend un nombre défini de millisecondes (-1 pour une attente infinie) avant
-		// de retourner le nombre de sockets actives.
-		int activeSockets = WSAPoll(pollDescriptors.data(), pollDescriptors.size(), 1);
-		if (activeSockets == SOCKET_ERROR)
+		// Rajoutons un client au lobby, avec son propre ID numérique
+		// (les connexions sont allouées individuellement pour que le pointeur associé à leur socket reste valide, y compris une fois confiées à un autre thread)
+		auto& connection = *lobby.connections.emplace_back(std::make_unique<Connection>());
+		connection.id = lobby.nextClientId++;
+		connection.socket = newClient;
+
+		if (!lobby.poller.Register(newClient, &connection))
 		{
-			std::cerr << "failed to poll sockets (" << WSAGetLastError() << ")\n";
-			return EXIT_FAILURE;
+			std::cerr << "failed to register client socket (" << WSAGetLastError() << ")\n";
+			closesocket(newClient);
+			lobby.connections.pop_back();
+			continue;
 		}
 
-		// activeSockets peut avoir trois valeurs différentes :
-		// - SOCKET_ERROR en cas d'erreur (géré plus haut)
-		// - 0 si aucune socket ne s'est activée avant la fin du délai
-		// - > 0, avec le nombre de sockets activées
-		// Dans notre cas, comme le délai est infini et l'erreur gérée plus haut, nous ne pouvons qu'avec un nombre positifs de sockets
+		// Représente une adresse IP (celle du client venant de se connecter) sous forme textuelle
+		char strAddr[INET_ADDRSTRLEN];
+		inet_ntop(clientAddr.sin_family, &clientAddr.sin_addr, strAddr, INET_ADDRSTRLEN);
+
+		std::cout << "player #" << connection.id << " connected from " << strAddr << std::endl;
 
-		if (activeSockets > 0)
+		// Le joueur n'entre en jeu qu'une fois la version du protocole négociée et sa salle choisie (voir handle_lobby_message)
+	}
+}
+
+void adopt_connections(Lobby& lobby, IoThread& ioThread)
+{
+	// On récupère d'un coup tous les joueurs confiés par le lobby, pour ne pas garder le verrou pendant leur arrivée
+	std::vector<std::unique_ptr<Connection>> newConnections;
+	{
+		std::lock_guard<std::mutex> lock(ioThread.inboxMutex);
+		newConnections.swap(ioThread.inbox);
+	}
+
+	for (std::unique_ptr<Connection>& newConnection : newConnections)
+	{
+		GameState& gameState = *newConnection->gameState;
+
+		auto& connection = *ioThread.connections.emplace_back(std::move(newConnection));
+		if (!ioThread.poller.Register(connection.socket, &connection))
 		{
-			// WSAPoll modifie le champ revents des descripteurs passés en paramètre pour indiquer les événements déclenchés
-			for (WSAPOLLFD& descriptor : pollDescriptors)
-			{
-				// Si ce descripteur n'a pas été actif, on passe au suivant
-				if (descriptor.revents == 0)
-					continue;
-
-				// Ce descripteur a été déclenché, et deux cas de figures sont possibles.
-				// Soit il s'agit du descripteur de la socket serveur (celle permettant la connexion de clients), signifiant qu'un nouveau client est en attente
-				// Soit une socket client est active, signifiant que nous avons reçu des données (ou potentiellement que le client s'est déconnecté)
-				if (descriptor.fd == sock)
-				{
-					// Nous sommes dans le cas du serveur, un nouveau client est donc disponible
-					sockaddr_in clientAddr;
-					int clientAddrSize = sizeof(clientAddr);
+			std::cerr << "failed to register client socket (" << WSAGetLastError() << ")\n";
+			closesocket(connection.socket);
+			ioThread.connections.pop_back();
+			gameState.playerCount--;
+			continue;
+		}
 
-					SOCKET newClient = accept(sock, reinterpret_cast<sockaddr*>(&clientAddr), &clientAddrSize);
-					if (newClient == INVALID_SOCKET)
-					{
-						std::cerr << "failed to accept new client (" << WSAGetLastError() << ")\n";
-						return EXIT_FAILURE;
-					}
+		std::cout << "player #" << connection.id << " joined room #" << gameState.id << std::endl;
 
-					// Rajoutons un client à notre tableau, avec son propre ID numérique
-					auto& player = gameState.players.emplace_back();
-					player.id = nextClientId++;
-					player.socket = newClient;
+		// La salle accueillera le joueur (serpent, S_Welcome, grille) lors de sa prochaine échéance
+		push_room_event(gameState, { connection.id, RoomEventType::PlayerJoined });
+		wake_room(lobby, gameState);
 
-					// Représente une adresse IP (celle du client venant de se connecter) sous forme textuelle
-					char strAddr[INET_ADDRSTRLEN];
-					inet_ntop(clientAddr.sin_family, &clientAddr.sin_addr, strAddr, INET_ADDRSTRLEN);
+		// Le client a pu envoyer d'autres messages à la suite de C_JoinRoom, ceux-ci sont restés dans son buffer de réception
+		if (!process_messages(connection))
+			disconnect_connection(ioThread, connection);
+	}
+}
 
-					std::cout << "player #" << player.id << " connected from " << strAddr << std::endl;
+void disconnect_connection(IoThread& ioThread, Connection& connection)
+{
+	// Ici aussi nous pourrions envoyer un message à tous les clients pour notifier la déconnexion d'un client
 
-					// Ici nous pourrions envoyer un message à tous les clients pour indiquer la connexion d'un nouveau client
+	// On oublie pas de fermer la socket avant de supprimer le client de la liste, la salle retirera son serpent du terrain
+	ioThread.poller.Unregister(connection.socket);
+	closesocket(connection.socket);
 
-					player.snake.emplace(sf::Vector2i(GridWidth / 2, GridHeight / 2), sf::Vector2i(1, 0), Color{ std::uint8_t(rand() % 0xFF), std::uint8_t(rand() % 0xFF), std::uint8_t(rand() % 0xFF) });
+	GameState& gameState = *connection.gameState;
+	push_room_event(gameState, { connection.id, RoomEventType::PlayerLeft });
+	gameState.playerCount--;
 
-					send_grid(gameState, player);
-				}
-				else
+	auto flushIt = std::find(ioThread.connectionsToFlush.begin(), ioThread.connectionsToFlush.end(), &connection);
+	if (flushIt != ioThread.connectionsToFlush.end())
+		ioThread.connectionsToFlush.erase(flushIt);
+
+	auto evictIt = std::find(ioThread.connectionsToEvict.begin(), ioThread.connectionsToEvict.end(), &connection);
+	if (evictIt != ioThread.connectionsToEvict.end())
+		ioThread.connectionsToEvict.erase(evictIt);
+
+	auto it = std::find_if(ioThread.connections.begin(), ioThread.connections.end(), [&](const std::unique_ptr<Connection>& c)
+	{
+		return c.get() == &connection;
+	});
+	assert(it != ioThread.connections.end());
+
+	ioThread.connections.erase(it);
+}
+
+void disconnect_lobby_connection(Lobby& lobby, Connection& connection)
+{
+	lobby.poller.Unregister(connection.socket);
+	closesocket(connection.socket);
+
+	// Le joueur a pu être compté dans une salle (C_JoinRoom) avant qu'un message suivant ne soit invalide, il n'y arrivera jamais
+	if (connection.gameState)
+		connection.gameState->playerCount--;
+
+	auto it = std::find_if(lobby.connections.begin(), lobby.connections.end(), [&](const std::unique_ptr<Connection>& c)
+	{
+		return c.get() == &connection;
+	});
+	assert(it != lobby.connections.end());
+
+	lobby.connections.erase(it);
+}
+
+void dispatch_room_packet(IoThread& ioThread, GameState& gameState, const RoomPacket& roomPacket)
+{
+	// Les rapports de la salle sont écrits d'un seul bloc, pour ne pas être entremêlés avec ceux des autres salles du thread
+	if (roomPacket.type == RoomPacketType::Report)
+	{
+		std::cout << roomPacket.text << std::flush;
+		return;
+	}
+	else if (roomPacket.type == RoomPacketType::Warning)
+	{
+		std::cerr << roomPacket.text << std::flush;
+		return;
+	}
+
+	// Le paquet a été encodé une seule fois par la salle, chaque joueur n'en reçoit qu'une référence dans sa file d'envoi
+	for (auto& connectionPtr : ioThread.connections)
+	{
+		Connection& connection = *connectionPtr;
+		if (connection.gameState != &gameState)
+			continue;
+
+		if (roomPacket.playerId == AllPlayers)
+		{
+			if (!connection.isReady)
+				continue;
+		}
+		else if (connection.id != roomPacket.playerId)
+			continue;
+
+		switch (roomPacket.type)
+		{
+			case RoomPacketType::Delta:
+			{
+				// Un delta ne s'applique qu'à l'état précédent : si celui-ci n'a pas encore été envoyé (et serait donc abandonné au profit du delta),
+				// on abandonne plutôt le delta et on demande l'état complet à la salle, les deltas suivants étant abandonnés jusqu'à sa réception
+				if (!connection.awaitingKeyframe && connection.outboundQueue.HasPendingReplaceable())
 				{
-					// Nous sommes dans le cas où le descripteur représente un client, tâchons de retrouver lequel
-					auto clientIt = std::find_if(gameState.players.begin(), gameState.players.end(), [&](const Player& c)
-					{
-						return c.socket == descriptor.fd;
-					});
-					assert(clientIt != gameState.players.end());
-
-					Player& client = *clientIt;
-
-					// La socket a été activée, tentons une lecture
-					char buffer[1024];
-					int byteRead = recv(client.socket, buffer, sizeof(buffer), 0);
-					if (byteRead == SOCKET_ERROR || byteRead == 0)
-					{
-						// Une erreur s'est produite ou le nombre d'octets lus est de zéro, indiquant une déconnexion
-						// on adapte le message en fonction.
-						if (byteRead == SOCKET_ERROR)
-							std::cerr << "failed to read from client #" << client.id << " (" << WSAGetLastError() << "), disconnecting..." << std::endl;
-						else
-							std::cout << "client #" << client.id << " disconnected" << std::endl;
-
-						// Ici aussi nous pourrions envoyer un message à tous les clients pour notifier la déconnexion d'un client
-
-						// On oublie pas de fermer la socket avant de supprimer le client de la liste
-						closesocket(client.socket);
-						gameState.players.erase(clientIt);
-					}
-					else
-					{
-						// Nous avons reçu un message de la part du client, affichons-le et renvoyons le aux autres clients
-
-						std::size_t oldSize = client.pendingData.size();
-						client.pendingData.resize(oldSize + byteRead);
-						std::memcpy(&client.pendingData[oldSize], buffer, byteRead);
-
-						while (client.pendingData.size() >= sizeof(std::uint16_t))
-						{
-							// -- Réception du message --
-
-							// On déserialise la taille du message
-							std::uint16_t messageSize;
-							std::memcpy(&messageSize, &client.pendingData[0], sizeof(messageSize));
-
-							messageSize = ntohs(messageSize);
-
-							if (client.pendingData.size() - sizeof(messageSize) < messageSize)
-								break;
-
-							// On traite le message reçu pour ce client
-							handle_message(client, client.pendingData, sizeof(messageSize), gameState);
-
-							// On retire la taille que nous de traiter des données en attente
-							std::size_t handledSize = sizeof(messageSize) + messageSize;
-							client.pendingData.erase(client.pendingData.begin(), client.pendingData.begin() + handledSize);
-						}
-					}
+					connection.awaitingKeyframe = true;
+					push_room_event(gameState, { connection.id, RoomEventType::KeyframeNeeded });
 				}
+
+				if (!connection.awaitingKeyframe)
+					queue_packet(ioThread, connection, roomPacket.packet, true);
+
+				break;
 			}
+
+			case RoomPacketType::Keyframe:
+				connection.awaitingKeyframe = false;
+				queue_packet(ioThread, connection, roomPacket.packet, true);
+				break;
+
+			case RoomPacketType::Welcome:
+				connection.isReady = true;
+				queue_packet(ioThread, connection, roomPacket.packet);
+				break;
+
+			case RoomPacketType::Reliable:
+				queue_packet(ioThread, connection, roomPacket.packet);
+				break;
+
+			case RoomPacketType::Report:
+			case RoomPacketType::Warning:
+				break; //< affichés avant la boucle, aucun joueur ne les reçoit
 		}
 
-		sf::Time now = gameState.clock.getElapsedTime();
+		// Un paquet destiné à un seul joueur n'a pas besoin de parcourir les suivants
+		if (roomPacket.playerId != AllPlayers)
+			break;
+	}
+}
+
+void broadcast_grid_update(GameState& gameState)
+{
+	if (gameState.dirtyCells.empty())
+		return;
+
+	// Envoi d'un seul paquet regroupant toutes les cellules de la grille modifiées depuis le dernier envoi
+	// (chaque cellule est envoyée avec son contenu actuel, une cellule modifiée plusieurs fois ne pose donc pas de problème)
+	ByteWriter packet(2 + 1 + 5 + gameState.dirtyCells.size() * (5 + 5 + 1));
+	std::size_t sizeOffset = BeginMessage(packet, Opcode::S_GridUpdate);
+
+	Serialize_varuint(packet, static_cast<std::uint32_t>(gameState.dirtyCells.size()));
+	for (const sf::Vector2i& cellPos : gameState.dirtyCells)
+	{
+		Serialize_varuint(packet, cellPos.x);
+		Serialize_varuint(packet, cellPos.y);
+		Serialize_u8(packet, static_cast<std::uint8_t>(gameState.simulation.GetGrid().GetCell(cellPos.x, cellPos.y)));
+	}
+
+	EndMessage(packet, sizeOffset);
+
+	gameState.dirtyCells.clear();
+
+	push_room_packet(gameState, AllPlayers, MakeSharedPacket(packet), RoomPacketType::Reliable);
+}
+
+SharedPacket build_game_state(GameState& gameState)
+{
+	// État complet de tous les serpents
+	// on calcule d'abord la taille du paquet pour n'allouer la mémoire qu'une seule fois
+	// (ainsi que le nombre de serpents, qui précède ceux-ci)
+	std::size_t packetSize = 2 + 4 + 1 + 5 + 5;
+	std::uint32_t snakeCount = 0;
+	for (auto& playerPtr : gameState.players)
+	{
+		if (!playerPtr->snake)
+			continue;
+
+		packetSize += 5 + 3 + 5 * 3 + 1 + playerPtr->snake->GetBody().size() / 4 + 1;
+		snakeCount++;
+	}
+
+	ByteWriter packet(packetSize);
+	std::size_t sizeOffset = BeginMessage(packet, Opcode::S_GameState);
 
-		// On vérifie si assez de temps s'est écoulé pour faire avancer la logique du jeu
-		if (now >= gameState.nextTick)
+	// Le tick identifie l'état, le client le renvoie avec ses directions
+	Serialize_varuint(packet, gameState.simulation.GetTickIndex());
+	Serialize_varuint(packet, snakeCount);
+	for (auto& playerPtr : gameState.players)
+	{
+		Player& player = *playerPtr;
+		if (!player.snake)
+			continue;
+
+		Serialize_varuint(packet, player.id);
+		serialize_snake(packet, *player.snake);
+	}
+
+	EndMessage(packet, sizeOffset);
+
+	return MakeSharedPacket(packet);
+}
+
+SharedPacket build_game_state_delta(GameState& gameState)
+{
+	// Modifications des serpents depuis le tick précédent : en dehors des (ré)apparitions,
+	// seule la nouvelle tête est envoyée, la taille du paquet ne dépend donc pas de la longueur des serpents
+	std::uint32_t entryCount = static_cast<std::uint32_t>(gameState.removedSnakes.size());
+	for (auto& playerPtr : gameState.players)
+	{
+		if (playerPtr->snake)
+			entryCount++;
+	}
+
+	ByteWriter packet(2 + 1 + 5 + 5 + entryCount * (5 + 1 + 5 * 2));
+	std::size_t sizeOffset = BeginMessage(packet, Opcode::S_GameStateDelta);
+
+	Serialize_varuint(packet, gameState.simulation.GetTickIndex());
+	Serialize_varuint(packet, entryCount);
+	for (unsigned int snakeId : gameState.removedSnakes)
+	{
+		Serialize_varuint(packet, snakeId);
+		Serialize_u8(packet, static_cast<std::uint8_t>(SnakeDeltaType::Removed));
+	}
+
+	for (auto& playerPtr : gameState.players)
+	{
+		Player& player = *playerPtr;
+		if (!player.snake)
+			continue;
+
+		Serialize_varuint(packet, player.id);
+		if (player.snakeReset)
+		{
+			Serialize_u8(packet, static_cast<std::uint8_t>(SnakeDeltaType::Reset));
+			serialize_snake(packet, *player.snake);
+		}
+		else
 		{
-			// On met à jour la logique du jeu
-			tick(gameState, now);
+			// Le client reproduit lui-même l'avancée et la croissance du serpent
+			Serialize_u8(packet, static_cast<std::uint8_t>((player.snakeGrew) ? SnakeDeltaType::MovedAndGrew : SnakeDeltaType::Moved));
 
-			// On prévoit la prochaine mise à jour
-			gameState.nextTick += gameState.tickInterval;
+			sf::Vector2i headPos = player.snake->GetHeadPosition();
+			Serialize_varuint(packet, headPos.x);
+			Serialize_varuint(packet, headPos.y);
 		}
 	}
 
-	return EXIT_SUCCESS;
+	EndMessage(packet, sizeOffset);
+
+	return MakeSharedPacket(packet);
+}
+
+int get_io_thread_timeout(IoThread& ioThread)
+{
+	// Le thread s'est annoncé endormi avant d'appeler cette fonction : une salle ajoutant un paquet après la vérification de sa file
+	// le trouvera donc endormi et le réveillera, alors qu'un paquet ajouté avant est vu ici (la barrière empêche l'inversion des deux)
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+
+	int timeout = -1;
+	for (GameState* gameState : ioThread.rooms)
+	{
+		if (!gameState->packets.IsEmpty())
+			return 0;
+
+		// Des événements attendent qu'une place se libère dans la file de la salle, on retentera bientôt
+		if (!gameState->eventBacklog.empty())
+			timeout = 1;
+	}
+
+	return timeout;
 }
 
-void broadcast_grid_update(GameState& gameState, int cellX, int cellY)
+IoThread& get_room_io_thread(Lobby& lobby, unsigned int roomId)
 {
-	// Envoi d'un paquet de mise à jour d'une cellule de la grille
-	std::vector<std::uint8_t> packet;
-	std::size_t sizeOffset = packet.size();
-	Serialize_u16(packet, 0);
-	Serialize_u8(packet, static_cast<std::uint8_t>(Opcode::S_GridUpdate));
+	// Les salles sont réparties à tour de rôle entre les threads d'entrées/sorties
+	return *lobby.ioThreads[(roomId - 1) % lobby.ioThreads.size()];
+}
+
+Worker& get_room_worker(Lobby& lobby, unsigned int roomId)
+{
+	// Les salles sont réparties à tour de rôle entre les threads
+	return *lobby.workers[(roomId - 1) % lobby.workers.size()];
+}
 
-	Serialize_u8(packet, cellX);
-	Serialize_u8(packet, cellY);
-	Serialize_u8(packet, static_cast<std::uint8_t>(gameState.grid.GetCell(cellX, cellY)));
+void hand_over_connection(Lobby& lobby, Connection& connection)
+{
+	// La socket quitte le poller du lobby pour celui du thread d'entrées/sorties de la salle, qui sera désormais le seul à la manipuler
+	lobby.poller.Unregister(connection.socket);
+
+	auto it = std::find_if(lobby.connections.begin(), lobby.connections.end(), [&](const std::unique_ptr<Connection>& c)
+	{
+		return c.get() == &connection;
+	});
+	assert(it != lobby.connections.end());
 
-	Serialize_u16(packet, sizeOffset, packet.size() - sizeof(std::uint16_t));
+	std::unique_ptr<Connection> connectionPtr = std::move(*it);
+	lobby.connections.erase(it);
 
-	for (Player& player : gameState.players)
+	IoThread& ioThread = get_room_io_thread(lobby, connection.gameState->id);
 	{
-		if (send(player.socket, reinterpret_cast<const char*>(packet.data()), packet.size(), 0) == SOCKET_ERROR)
-			std::cerr << "failed to send data to player #" << player.id << " (" << WSAGetLastError() << ")" << std::endl;
+		std::lock_guard<std::mutex> lock(ioThread.inboxMutex);
+		ioThread.inbox.push_back(std::move(connectionPtr));
 	}
+
+	// Le thread est peut-être en attente de ses sockets, on le réveille pour qu'il prenne le joueur en charge
+	ioThread.poller.Wakeup();
 }
 
-void handle_message(Player& player, const std::vector<std::uint8_t>& message, std::size_t offset, GameState& gameState)
+bool handle_lobby_message(Lobby& lobby, Connection& connection, ByteReader& message)
 {
-	// On traite les messages reçus par un joueur, différenciés par l'opcode
-	Opcode opcode = static_cast<Opcode>(Unserialize_u8(message, offset));
+	// Seuls la poignée de main et le choix de la salle sont acceptés dans le lobby
+	Opcode opcode = static_cast<Opcode>(Unserialize_u8(message));
+
 	switch (opcode)
 	{
-		case Opcode::C_UpdateDirection:
+		case Opcode::C_Hello:
 		{
-			SnakeDirection newDirection = static_cast<SnakeDirection>(Unserialize_u8(message, offset));
-			sf::Vector2i directionVec;
-			switch (newDirection)
-			{
-				case SnakeDirection::Left:
-					directionVec = sf::Vector2i(-1, 0);
-					break;
+			std::uint32_t clientVersion = Unserialize_varuint(message);
+			if (message.HasError() || connection.helloReceived)
+				return false;
 
-				case SnakeDirection::Right:
-					directionVec = sf::Vector2i(1, 0);
-					break;
+			// Le client indique la version la plus récente qu'il comprend, nous ne savons parler que la nôtre
+			if (clientVersion < ProtocolVersion)
+			{
+				std::cerr << "player #" << connection.id << " uses protocol version " << clientVersion << " (version " << ProtocolVersion << " is required)" << std::endl;
+				return false;
+			}
 
-				case SnakeDirection::Up:
-					directionVec = sf::Vector2i(0, -1);
-					break;
+			connection.helloReceived = true;
+			break;
+		}
 
-				case SnakeDirection::Down:
-					directionVec = sf::Vector2i(0, 1);
-					break;
+		case Opcode::C_JoinRoom:
+		{
+			std::uint32_t roomId = Unserialize_varuint(message);
+			if (message.HasError() || !connection.helloReceived)
+				return false;
 
-				default:
-					return;
+			GameState* room = select_room(lobby, roomId);
+			if (!room)
+			{
+				std::cerr << "player #" << connection.id << " cannot join room #" << roomId << " (unknown or full room)" << std::endl;
+				return false;
 			}
 
-			if (directionVec != -player.snake->GetCurrentDirection())
-				player.snake->SetFollowingDirection(directionVec);
+			// Le joueur est compté dès maintenant, pour que la salle ne dépasse pas sa capacité avant qu'il y soit arrivé
+			room->playerCount++;
+			connection.gameState = room;
+			break;
+		}
+
+		default:
+			return false;
+	}
+
+	// Un message tronqué (ou d'opcode inconnu) est invalide, ce qui entraînera la déconnexion du client
+	return !message.HasError();
+}
+
+bool handle_message(Connection& connection, ByteReader& message)
+{
+	// On traite les messages reçus par un joueur, différenciés par l'opcode
+	Opcode opcode = static_cast<Opcode>(Unserialize_u8(message));
+
+	// La poignée de main et le choix de la salle ont eu lieu dans le lobby, avant que le joueur n'arrive dans celle-ci
+	switch (opcode)
+	{
+		case Opcode::C_UpdateDirection:
+		{
+			SnakeDirection newDirection = static_cast<SnakeDirection>(Unserialize_u8(message));
+			std::uint32_t tick = Unserialize_varuint(message);
+			if (message.HasError() || newDirection > SnakeDirection::Down)
+				return false;
 
+			// La direction est transmise à la salle, dont la simulation l'ajoutera à la file des directions du serpent
+			push_room_event(*connection.gameState, { connection.id, RoomEventType::DirectionChanged, newDirection, tick });
 			break;
 		}
+
+		default:
+			return false;
 	}
+
+	// Un message tronqué (ou d'opcode inconnu) est invalide, ce qui entraînera la déconnexion du client
+	return !message.HasError();
 }
 
-void send_grid(GameState& gameState, Player& player)
+Player* find_player(GameState& gameState, unsigned int playerId)
 {
-	// Envoi de toute la grille à un joueur
-	std::vector<std::uint8_t> packet;
-	std::size_t sizeOffset = packet.size();
-	Serialize_u16(packet, 0);
-	Serialize_u8(packet, static_cast<std::uint8_t>(Opcode::S_GridState));
+	auto it = std::find_if(gameState.players.begin(), gameState.players.end(), [&](const std::unique_ptr<Player>& p)
+	{
+		return p->id == playerId;
+	});
+
+	return (it != gameState.players.end()) ? it->get() : nullptr;
+}
 
-	Serialize_u8(packet, gameState.grid.GetWidth());
-	Serialize_u8(packet, gameState.grid.GetHeight());
+void flush_connections(IoThread& ioThread)
+{
+	// On ne parcourt que les joueurs ayant de nouveaux paquets en attente
+	// (ceux dont la socket est pleine seront servis lorsqu'elle sera à nouveau disponible en écriture)
+	std::vector<Connection*> failedConnections;
+	for (Connection* connection : ioThread.connectionsToFlush)
+	{
+		if (!send_data(ioThread, *connection))
+			failedConnections.push_back(connection);
+	}
+	ioThread.connectionsToFlush.clear();
 
-	std::size_t cellCountOffset = packet.size();
-	Serialize_u16(packet, 0);
+	for (Connection* connection : failedConnections)
+		disconnect_connection(ioThread, *connection);
 
-	std::uint16_t fullCellCount = 0;
-	for (int y = 0; y < gameState.grid.GetHeight(); ++y)
+	// disconnect_connection retire le joueur de la liste
+	while (!ioThread.connectionsToEvict.empty())
 	{
-		for (int x = 0; x < gameState.grid.GetWidth(); ++x)
-		{
-			CellType cellType = gameState.grid.GetCell(x, y);
-			if (cellType == CellType::None)
-				continue;
+		Connection& connection = *ioThread.connectionsToEvict.back();
+		std::cerr << "player #" << connection.id << " is too slow (" << connection.outboundQueue.GetPendingSize() << " bytes pending), disconnecting..." << std::endl;
 
-			Serialize_u8(packet, x);
-			Serialize_u8(packet, y);
-			Serialize_u8(packet, static_cast<std::uint8_t>(cellType));
+		disconnect_connection(ioThread, connection);
+	}
+}
+
+void flush_event_backlog(GameState& gameState)
+{
+	std::size_t pushedCount = 0;
+	while (pushedCount < gameState.eventBacklog.size() && gameState.events.TryPush(std::move(gameState.eventBacklog[pushedCount])))
+		pushedCount++;
 
-			fullCellCount++;
+	gameState.eventBacklog.erase(gameState.eventBacklog.begin(), gameState.eventBacklog.begin() + pushedCount);
+}
+
+void flush_packet_backlog(GameState& gameState)
+{
+	std::size_t pushedCount = 0;
+	while (pushedCount < gameState.packetBacklog.size() && gameState.packets.TryPush(std::move(gameState.packetBacklog[pushedCount])))
+		pushedCount++;
+
+	gameState.packetBacklog.erase(gameState.packetBacklog.begin(), gameState.packetBacklog.begin() + pushedCount);
+
+	if (pushedCount > 0)
+		gameState.packetsPushed = true;
+}
+
+bool process_messages(Connection& connection)
+{
+	// On traite tous les messages complets, directement depuis le buffer de réception
+	while (std::optional<ByteReader> message = connection.receiveBuffer.PopMessage())
+	{
+		// Un message invalide entraîne la déconnexion du client
+		if (!handle_message(connection, *message))
+		{
+			std::cerr << "received malformed message from client #" << connection.id << ", disconnecting..." << std::endl;
+			return false;
 		}
 	}
 
-	Serialize_u16(packet, cellCountOffset, fullCellCount);
+	if (connection.receiveBuffer.HasError())
+	{
+		std::cerr << "client #" << connection.id << " sent an oversized message, disconnecting..." << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+void process_room_events(GameState& gameState)
+{
+	// Les événements sont traités dans l'ordre où le thread d'entrées/sorties les a produits
+	RoomEvent event;
+	while (gameState.events.TryPop(event))
+	{
+		switch (event.type)
+		{
+			case RoomEventType::DirectionChanged:
+				// La direction n'est mise en file qu'au prochain tick, par la simulation
+				gameState.pendingInputs.push_back({ event.playerId, event.direction, event.tick });
+				break;
+
+			case RoomEventType::KeyframeNeeded:
+			{
+				if (Player* player = find_player(gameState, event.playerId))
+					player->needsKeyframe = true;
+
+				break;
+			}
+
+			case RoomEventType::PlayerJoined:
+				welcome_player(gameState, event.playerId);
 
-	Serialize_u16(packet, sizeOffset, packet.size() - sizeof(std::uint16_t));
+				// Une salle restée sans joueur reprend ses mises à jour
+				schedule_game_timers(gameState);
+				break;
 
-	if (send(player.socket, reinterpret_cast<const char*>(packet.data()), packet.size(), 0) == SOCKET_ERROR)
-		std::cerr << "failed to send data to player #" << player.id << " (" << WSAGetLastError() << ")" << std::endl;
+			case RoomEventType::PlayerLeft:
+				remove_player(gameState, event.playerId);
+				break;
+		}
+	}
 }
 
-void tick(GameState& gameState, const sf::Time& now)
+void process_room_timers(Lobby& lobby, GameState& gameState)
 {
-	if (now >= gameState.nextAppleSpawn)
+	// Les paquets n'ayant pas encore trouvé de place partent avant ceux que produiront les échéances,
+	// qui s'appliquent après les événements reçus depuis la dernière exécution (arrivées, directions, ...)
+	flush_packet_backlog(gameState);
+	process_room_events(gameState);
+
+	// On traite les échéances passées (mise à jour du jeu, apparition des pommes, ...)
+	gameState.timers.Process(gameState.clock.getElapsedTime());
+
+	// La prochaine échéance de la salle revient à son thread, qui sera prioritaire pour l'exécuter
+	// (le planificateur sépare cette exécution de la suivante, quel que soit le thread qui s'en chargera)
+	if (std::optional<sf::Time> nextDeadline = gameState.timers.GetNextDeadline())
+		lobby.roomScheduler.Schedule(get_room_worker(lobby, gameState.id).index, gameState.id, *nextDeadline);
+
+	// Les paquets produits sont envoyés par le thread d'entrées/sorties de la salle, réveillé une fois la salle exécutée
+	// (une salle n'ayant rien produit, comme une salle vide, ne fait donc aucun appel système)
+	if (gameState.packetsPushed)
 	{
-		// On évite de placer une pomme sur une case pleine (ou un serpent)
-		int x = rand() % gameState.grid.GetWidth();
-		int y = rand() % gameState.grid.GetHeight();
+		gameState.packetsPushed = false;
+		wake_io_thread(get_room_io_thread(lobby, gameState.id));
+	}
+}
 
-		if (gameState.grid.GetCell(x, y) == CellType::None)
+void process_simulation_events(GameState& gameState)
+{
+	for (const SimulationEvent& event : gameState.simulation.GetEvents())
+	{
+		switch (event.type)
 		{
-			bool snakeTest = false;
+			case SimulationEventType::CellChanged:
+				gameState.dirtyCells.push_back(event.position);
+				break;
 
-			for (Player& player : gameState.players)
+			case SimulationEventType::SnakeCollided:
 			{
-				if (!player.snake)
-					continue;
+				// Le serpent percuté marque un point
+				if (event.collisionType == CollisionType::Body)
+					find_player(gameState, event.otherId)->kills++;
 
-				if (player.snake->TestCollision(sf::Vector2i(x, y), true))
-				{
-					snakeTest = true;
-					break;
-				}
+				break;
 			}
 
-			if (!snakeTest)
-			{
-				// La voie est libre, faisons apparaitre la pomme
-				gameState.grid.SetCell(x, y, CellType::Apple);
-				broadcast_grid_update(gameState, x, y);
+			case SimulationEventType::SnakeGrew:
+				find_player(gameState, event.snakeId)->snakeGrew = true;
+				break;
+
+			case SimulationEventType::SnakeSpawned:
+				find_player(gameState, event.snakeId)->snakeReset = true;
+				break;
+
+			case SimulationEventType::SnakeHitWall:
+			default:
+				break;
+		}
+	}
+
+	gameState.simulation.ClearEvents();
+}
+
+void push_room_event(GameState& gameState, const RoomEvent& event)
+{
+	// Les événements doivent arriver dans l'ordre : tant que d'anciens événements attendent une place, les nouveaux attendent derrière eux
+	RoomEvent queuedEvent = event;
+	if (!gameState.eventBacklog.empty() || !gameState.events.TryPush(std::move(queuedEvent)))
+		gameState.eventBacklog.push_back(event);
+}
+
+void push_room_packet(GameState& gameState, RoomPacket roomPacket)
+{
+	// Même chose pour les paquets, la file n'étant vidée par le thread d'entrées/sorties qu'une fois réveillé par la fin du tick
+	if (gameState.packetBacklog.empty() && gameState.packets.TryPush(std::move(roomPacket)))
+		gameState.packetsPushed = true;
+	else
+		gameState.packetBacklog.push_back(std::move(roomPacket));
+}
+
+void push_room_packet(GameState& gameState, unsigned int playerId, SharedPacket packet, RoomPacketType type)
+{
+	push_room_packet(gameState, RoomPacket{ std::move(packet), playerId, type, {} });
+}
+
+void push_room_report(GameState& gameState, RoomPacketType type, std::string text)
+{
+	// Les écritures sur la console sont des appels système bloquants : la salle les confie à son thread d'entrées/sorties
+	push_room_packet(gameState, RoomPacket{ nullptr, AllPlayers, type, std::move(text) });
+}
+
+bool put_room_to_sleep(GameState& gameState)
+{
+	// On s'annonce endormie avant de vérifier une dernière fois la file d'événements : un joueur confié ensuite à la salle
+	// la trouvera endormie et la réveillera, alors qu'un joueur confié avant est vu ici (la barrière empêche l'inversion des deux)
+	gameState.isSleeping = true;
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (gameState.events.IsEmpty())
+		return true;
+
+	// Des événements sont arrivés entre-temps : si le thread d'entrées/sorties nous a déjà vue endormie, il avance notre échéance
+	// pour nous réveiller, sinon nous restons éveillée pour les traiter
+	return !gameState.isSleeping.exchange(false);
+}
+
+void queue_packet(IoThread& ioThread, Connection& connection, SharedPacket packet, bool replaceable)
+{
+	// Un joueur en attente de sa socket sera servi par celle-ci, inutile de tenter un envoi avant
+	if (connection.outboundQueue.IsEmpty() && !connection.waitingWritable)
+		ioThread.connectionsToFlush.push_back(&connection);
+
+	connection.outboundQueue.Push(std::move(packet), replaceable);
+
+	std::size_t pendingSize = connection.outboundQueue.GetPendingSize();
+	if (pendingSize <= ioThread.outboundHighWaterMark)
+		return;
+
+	sf::Time now = ioThread.clock.getElapsedTime();
+	if (!connection.congestedSince)
+		connection.congestedSince = now;
+
+	// Le joueur ne peut pas être déconnecté ici (nous sommes potentiellement en train de parcourir la liste des joueurs)
+	if (pendingSize > ioThread.outboundHardLimit || now - *connection.congestedSince >= ioThread.slowClientTimeout)
+	{
+		if (std::find(ioThread.connectionsToEvict.begin(), ioThread.connectionsToEvict.end(), &connection) == ioThread.connectionsToEvict.end())
+			ioThread.connectionsToEvict.push_back(&connection);
+	}
+}
+
+bool read_socket(Connection& connection, bool& wouldBlock)
+{
+	// La socket a été activée, tentons une lecture (directement dans le buffer de réception du joueur)
+	std::uint8_t* buffer = connection.receiveBuffer.PrepareWrite();
+	int byteRead = recv(connection.socket, reinterpret_cast<char*>(buffer), static_cast<int>(connection.receiveBuffer.GetWritableSize()), 0);
+	if (byteRead == SOCKET_ERROR || byteRead == 0)
+	{
+		// Une erreur s'est produite ou le nombre d'octets lus est de zéro, indiquant une déconnexion
+		// on adapte le message en fonction.
+		if (byteRead == SOCKET_ERROR)
+		{
+			// Toutes les données disponibles ont été lues
+			wouldBlock = (WSAGetLastError() == WSAEWOULDBLOCK);
+			if (wouldBlock)
+				return true;
+
+			std::cerr << "failed to read from client #" << connection.id << " (" << WSAGetLastError() << "), disconnecting..." << std::endl;
+		}
+		else
+			std::cout << "client #" << connection.id << " disconnected" << std::endl;
 
-				gameState.nextAppleSpawn += gameState.appleSpawnInterval;
+		return false;
+	}
+
+	connection.receiveBuffer.Commit(byteRead);
+
+	wouldBlock = false;
+	return true;
+}
+
+bool receive_data(Connection& connection)
+{
+	for (;;)
+	{
+		bool wouldBlock;
+		if (!read_socket(connection, wouldBlock))
+			return false;
+
+		if (wouldBlock)
+			return true;
+
+		if (!process_messages(connection))
+			return false;
+
+		// Avec WSAPoll, la socket nous sera à nouveau signalée tant qu'il lui restera des données : une seule lecture suffit
+		// Avec epoll (edge-triggered) en revanche, il faut tout lire jusqu'à obtenir WSAEWOULDBLOCK
+		if (!Poller::EdgeTriggered)
+			return true;
+	}
+}
+
+bool receive_lobby_data(Lobby& lobby, Connection& connection)
+{
+	for (;;)
+	{
+		bool wouldBlock;
+		if (!read_socket(connection, wouldBlock))
+			return false;
+
+		if (wouldBlock)
+			return true;
+
+		// Les messages suivant C_JoinRoom restent dans le buffer de réception, ils seront traités par le thread d'entrées/sorties de la salle
+		while (!connection.gameState)
+		{
+			std::optional<ByteReader> message = connection.receiveBuffer.PopMessage();
+			if (!message)
+				break;
+
+			if (!handle_lobby_message(lobby, connection, *message))
+			{
+				std::cerr << "received malformed message from client #" << connection.id << ", disconnecting..." << std::endl;
+				return false;
 			}
 		}
+
+		if (connection.receiveBuffer.HasError())
+		{
+			std::cerr << "client #" << connection.id << " sent an oversized message, disconnecting..." << std::endl;
+			return false;
+		}
+
+		// Une fois la salle choisie, c'est à son thread d'entrées/sorties de lire la socket (il en sera averti dès son enregistrement s'il reste des données)
+		if (connection.gameState || !Poller::EdgeTriggered)
+			return true;
 	}
+}
 
-	// On fait d'abord avancer tous les serpents avant de résoudre les collisions
-	for (Player& player : gameState.players)
+void remove_player(GameState& gameState, unsigned int playerId)
+{
+	auto it = std::find_if(gameState.players.begin(), gameState.players.end(), [&](const std::unique_ptr<Player>& p)
 	{
-		if (!player.snake)
-			continue;
+		return p->id == playerId;
+	});
+	assert(it != gameState.players.end());
 
-		player.snake->Advance();
+	// Le serpent du joueur est retiré du terrain, sa disparition sera envoyée aux autres joueurs au prochain tick
+	Player& player = **it;
+	if (player.snake)
+	{
+		gameState.simulation.RemoveSnake(player.id);
+		gameState.removedSnakes.push_back(player.id);
 	}
 
-	// On teste les collisions
-	for (std::size_t i = 0; i < gameState.players.size(); ++i)
+	gameState.players.erase(it);
+}
+
+void run_io_thread(Lobby& lobby, IoThread& ioThread)
+{
+	std::vector<PollEvent> events;
+
+	while (!lobby.stopRequested)
 	{
-		Player& player = gameState.players[i];
-		if (!player.snake)
-			continue;
+		// Le thread n'a aucune échéance : il est réveillé par ses sockets, par le lobby (nouveau joueur) ou par ses salles (nouveaux paquets)
+		ioThread.sleeping = true;
+		bool pollSucceeded = ioThread.poller.Wait(events, get_io_thread_timeout(ioThread));
+		ioThread.sleeping = false;
+
+		if (!pollSucceeded)
+		{
+			std::cerr << "failed to poll sockets (" << WSAGetLastError() << ")\n";
+
+			// C'est au lobby d'arrêter le serveur
+			lobby.stopRequested = true;
+			lobby.poller.Wakeup();
+			return;
+		}
+
+		// Les joueurs confiés par le lobby rejoignent leur salle
+		adopt_connections(lobby, ioThread);
 
-		// On teste la collision de la tête du serpent avec la grille
-		sf::Vector2i headPos = player.snake->GetHeadPosition();
-		switch (gameState.grid.GetCell(headPos.x, headPos.y))
+		for (const PollEvent& event : events)
 		{
-			case CellType::Apple:
+			// Pas besoin de rechercher le client, le pointeur associé à sa socket nous y donne directement accès
+			// nous pouvons recevoir des données ou reprendre l'envoi de données qui étaient en attente
+			Connection& connection = *static_cast<Connection*>(event.userdata);
+
+			if (event.writable && !send_data(ioThread, connection))
+				disconnect_connection(ioThread, connection);
+			else if ((event.readable || event.disconnected) && !receive_data(connection))
+				disconnect_connection(ioThread, connection);
+		}
+
+		for (GameState* gameState : ioThread.rooms)
+		{
+			// Paquets produits par la salle depuis le dernier tour de boucle
+			RoomPacket roomPacket;
+			while (gameState->packets.TryPop(roomPacket))
+				dispatch_room_packet(ioThread, *gameState, roomPacket);
+
+			// Événements n'ayant pas trouvé de place dans la file de la salle (celle-ci a pu être vidée depuis),
+			// une arrivée parmi eux doit réveiller la salle
+			if (!gameState->eventBacklog.empty())
 			{
-				gameState.grid.SetCell(headPos.x, headPos.y, CellType::None);
-				broadcast_grid_update(gameState, headPos.x, headPos.y);
+				flush_event_backlog(*gameState);
+				wake_room(lobby, *gameState);
+			}
+		}
 
-				player.snake->Grow();
-				break;
+		// Et on envoie en une fois tout ce qui a été mis en file d'envoi pendant ce tour de boucle (et on exclut les clients trop lents)
+		flush_connections(ioThread);
+	}
+}
+
+int run_lobby(Lobby& lobby, SOCKET sock)
+{
+	std::vector<PollEvent> events;
+
+	// Boucle infinie pour continuer d'accepter des clients
+	for (;;)
+	{
+		// Le lobby n'a aucune échéance, il attend simplement que ses sockets s'activent (ou qu'un thread le réveille)
+		if (!lobby.poller.Wait(events, -1))
+		{
+			std::cerr << "failed to poll sockets (" << WSAGetLastError() << ")\n";
+			return EXIT_FAILURE;
+		}
+
+		// Un thread a rencontré une erreur fatale
+		if (lobby.stopRequested)
+			return EXIT_FAILURE;
+
+		for (const PollEvent& event : events)
+		{
+			// Soit un nouveau client est en attente sur la socket serveur, soit un client du lobby nous a envoyé des données
+			if (!event.userdata)
+			{
+				if (!accept_clients(lobby, sock))
+					return EXIT_FAILURE;
 			}
+			else
+			{
+				Connection& connection = *static_cast<Connection*>(event.userdata);
+				if (!receive_lobby_data(lobby, connection))
+					disconnect_lobby_connection(lobby, connection);
+				else if (connection.gameState)
+					hand_over_connection(lobby, connection);
+			}
+		}
+	}
+}
+
+void run_worker(Lobby& lobby, Worker& worker)
+{
+	while (!lobby.stopRequested)
+	{
+		// On exécute les échéances passées des salles, les plus en retard d'abord, en commençant par les nôtres
+		while (std::optional<DeadlineScheduler::Task> task = lobby.roomScheduler.PopDue(worker.index, lobby.clock.getElapsedTime()))
+			process_room_timers(lobby, *lobby.rooms[task->taskId - 1]);
+
+		// Puis on attend la plus proche des échéances de nos salles (ou de celles des autres threads, au cas où ceux-ci
+		// seraient trop occupés pour les honorer à temps) : les salles ne dépendent d'aucune socket, seuls l'arrêt du serveur
+		// et le réveil d'une salle endormie (dont l'échéance a été avancée, voir wake_room) peuvent nous réveiller plus tôt
+		unsigned int roomWakeups = lobby.roomWakeups;
+		int timeout = lobby.roomScheduler.GetTimeout(worker.index, lobby.clock.getElapsedTime());
+
+		std::unique_lock<std::mutex> lock(lobby.stopMutex);
+		auto isWakeupNeeded = [&] { return lobby.stopRequested.load() || lobby.roomWakeups != roomWakeups; };
+		if (timeout < 0)
+			lobby.stopCondition.wait(lock, isWakeupNeeded);
+		else
+			lobby.stopCondition.wait_for(lock, std::chrono::milliseconds(timeout), isWakeupNeeded);
+	}
+}
+
+void schedule_game_timers(GameState& gameState)
+{
+	TimerQueue& timers = gameState.timers;
+	sf::Time now = gameState.clock.getElapsedTime();
 
-			case CellType::Wall:
+	// Mise à jour de la logique du jeu, qui reprend sans rattraper les ticks d'une éventuelle période sans joueur
+	if (!gameState.isTickTimerArmed)
+	{
+		gameState.isTickTimerArmed = true;
+		gameState.tickScheduler.Restart(now);
+
+		timers.Schedule(gameState.tickScheduler.GetNextTick(), [&](const sf::Time& deadline, const sf::Time& now) -> std::optional<sf::Time>
+		{
+			gameState.tickJitter.Record(now - deadline);
+
+			// Si nous avons pris du retard, plusieurs ticks sont exécutés d'un coup pour rattraper l'horloge
+			unsigned int tickCount = gameState.tickScheduler.Update(now);
+			for (unsigned int i = 0; i < tickCount; ++i)
+				tick(gameState);
+
+			// Une salle sans joueur n'est plus mise à jour jusqu'à l'arrivée du prochain
+			if (gameState.players.empty() && put_room_to_sleep(gameState))
 			{
-				// Le serpent s'est pris un mur, on le fait r�apparaitre
-				player.snake->Respawn(sf::Vector2i(gameState.grid.GetWidth() / 2, gameState.grid.GetHeight() / 2), sf::Vector2i(1, 0));
-				continue;
+				gameState.isTickTimerArmed = false;
+				return std::nullopt;
 			}
 
-			case CellType::None:
-			default:
-				break;
+			// On prévoit la prochaine mise à jour
+			return gameState.tickScheduler.GetNextTick();
+		});
+	}
+
+	// Apparition des pommes
+	if (!gameState.isAppleTimerArmed)
+	{
+		gameState.isAppleTimerArmed = true;
+		gameState.nextAppleSpawn = now + gameState.appleSpawnInterval;
+
+		timers.Schedule(gameState.nextAppleSpawn, [&](const sf::Time& /*deadline*/, const sf::Time& now) -> std::optional<sf::Time>
+		{
+			// Ni pomme ni tick dans une salle sans joueur, l'arrivée du prochain reprogramme les deux
+			if (gameState.players.empty())
+			{
+				gameState.isAppleTimerArmed = false;
+				return std::nullopt;
+			}
+
+				// Si la pomme n'a pas pu apparaître, on retente au prochain tick
+			if (!spawn_apple(gameState))
+				return gameState.tickScheduler.GetNextTick();
+
+			// Après une longue période sans place libre, l'échéance prévue est loin dans le passé :
+			// on repart de maintenant plutôt que de faire apparaître d'un coup toutes les pommes manquées
+			gameState.nextAppleSpawn = std::max(gameState.nextAppleSpawn + gameState.appleSpawnInterval, now + gameState.appleSpawnInterval);
+			return gameState.nextAppleSpawn;
+		});
+	}
+}
+
+void schedule_timers(GameState& gameState)
+{
+	TimerQueue& timers = gameState.timers;
+
+	// Les salles démarrent sans joueur : seules les statistiques sont programmées, les ticks et les pommes
+	// le sont à l'arrivée du premier joueur (voir schedule_game_timers)
+
+	// Affichage régulier des statistiques
+	timers.Schedule(gameState.statsInterval, [&](const sf::Time& deadline, const sf::Time& /*now*/) -> std::optional<sf::Time>
+	{
+		// Les rapports sont formatés ici mais affichés par le thread d'entrées/sorties (voir push_room_report)
+		if (gameState.tickJitter.GetCount() > 0)
+		{
+			std::ostringstream report;
+			report << "room #" << gameState.id << " tick jitter: ";
+			gameState.tickJitter.Print(report);
+			gameState.tickJitter.Reset();
+
+			push_room_report(gameState, RoomPacketType::Report, report.str());
 		}
 
-		// Test de la self-collision
-		if (player.snake->TestCollision(headPos, false))
+		// On signale les surcharges du serveur (ticks rattrapés ou abandonnés)
+		const TickScheduler::Stats& tickStats = gameState.tickScheduler.GetStats();
+		if (tickStats.lateTicks > 0 || tickStats.droppedTicks > 0)
 		{
-			player.snake->Respawn(sf::Vector2i(gameState.grid.GetWidth() / 2, gameState.grid.GetHeight() / 2), sf::Vector2i(1, 0));
-			continue;
+			std::ostringstream warning;
+			warning << "room #" << gameState.id << " overloaded: " << tickStats.lateTicks << " late tick(s) caught up, " << tickStats.droppedTicks << " tick(s) dropped (out of " << tickStats.executedTicks + tickStats.droppedTicks << ")\n";
+
+			push_room_report(gameState, RoomPacketType::Warning, warning.str());
 		}
 
-		// Test de la collision avec un autre serpent
-		for (std::size_t j = 0; j < gameState.players.size(); ++j)
+		gameState.tickScheduler.ResetStats();
+
+		return deadline + gameState.statsInterval;
+	});
+}
+
+GameState* select_room(Lobby& lobby, std::uint32_t roomId)
+{
+	// Sans préférence du joueur, on choisit la salle la moins remplie
+	if (roomId == AnyRoom)
+	{
+		auto it = std::min_element(lobby.rooms.begin(), lobby.rooms.end(), [](const GameState* lhs, const GameState* rhs)
 		{
-			if (i == j)
-				continue;
+			return lhs->playerCount < rhs->playerCount;
+		});
+
+		roomId = (*it)->id;
+	}
+
+	if (roomId > lobby.rooms.size())
+		return nullptr;
+
+	// Les threads ne font que diminuer le nombre de joueurs d'une salle, celle-ci ne peut donc pas se remplir entre ce test et l'arrivée du joueur
+	GameState* room = lobby.rooms[roomId - 1];
+	return (room->playerCount < Lobby::MaxPlayersPerRoom) ? room : nullptr;
+}
+
+void send_game_state(GameState& gameState)
+{
+	// Un état complet est régulièrement envoyé à tout le monde, ce qui borne la durée d'une éventuelle désynchronisation
+	bool keyframeTick = (++gameState.ticksSinceKeyframe >= GameState::KeyframeInterval);
+	if (keyframeTick)
+		gameState.ticksSinceKeyframe = 0;
+
+	// Les modifications de la grille partent dans le même envoi que l'état des serpents
+	broadcast_grid_update(gameState);
+
+	// Chaque paquet n'est encodé qu'une fois (et seulement si au moins un joueur en a besoin)
+	if (keyframeTick)
+	{
+		if (!gameState.players.empty())
+			push_room_packet(gameState, AllPlayers, build_game_state(gameState), RoomPacketType::Keyframe);
+
+		for (auto& playerPtr : gameState.players)
+			playerPtr->needsKeyframe = false;
+	}
+	else if (!gameState.players.empty())
+	{
+		push_room_packet(gameState, AllPlayers, build_game_state_delta(gameState), RoomPacketType::Delta);
 
-			Player& otherPlayer = gameState.players[j];
-			if (!otherPlayer.snake)
+		// Un joueur venant d'arriver, ou dont un delta n'a pas pu être envoyé, reçoit ensuite l'état complet
+		// (le thread d'entrées/sorties abandonne le delta pour ce joueur, qui n'a pas l'état auquel il s'applique)
+		SharedPacket keyframe;
+		for (auto& playerPtr : gameState.players)
+		{
+			Player& player = *playerPtr;
+			if (!player.needsKeyframe)
 				continue;
 
-			if (otherPlayer.snake->TestCollision(headPos, true))
-			{
-				player.snake->Respawn(sf::Vector2i(gameState.grid.GetWidth() / 2, gameState.grid.GetHeight() / 2), sf::Vector2i(1, 0));
-				break;
-			}
+			if (!keyframe)
+				keyframe = build_game_state(gameState);
+
+			push_room_packet(gameState, player.id, keyframe, RoomPacketType::Keyframe);
+			player.needsKeyframe = false;
 		}
 	}
 
-	// Envoi de l'état de tous les serpents à tout le monde
-	std::vector<std::uint8_t> packet;
-	std::size_t sizeOffset = packet.size();
-	Serialize_u16(packet, 0);
-	Serialize_u8(packet, static_cast<std::uint8_t>(Opcode::S_GameState));
+	// Les modifications ont été envoyées, on repart de zéro pour le prochain tick
+	for (auto& playerPtr : gameState.players)
+	{
+		playerPtr->snakeGrew = false;
+		playerPtr->snakeReset = false;
+	}
+	gameState.removedSnakes.clear();
+}
+
+void send_grid(GameState& gameState, Player& player)
+{
+	// Envoi de toute la grille à un joueur
+	ByteWriter packet;
+	std::size_t sizeOffset = BeginMessage(packet, Opcode::S_GridState);
+
+	const Grid& grid = gameState.simulation.GetGrid();
+	Serialize_varuint(packet, grid.GetWidth());
+	Serialize_varuint(packet, grid.GetHeight());
+
+	// Le contenu est encodé de la façon la plus compacte (par plages ou sur deux bits par cellule)
+	Serialize_grid_cells(packet, grid);
+
+	EndMessage(packet, sizeOffset);
 
-	std::size_t snakeCountOffset = packet.size();
-	Serialize_u8(packet, 0);
+	push_room_packet(gameState, player.id, MakeSharedPacket(packet), RoomPacketType::Reliable);
+}
 
-	std::uint8_t snakeCount = 0;
-	for (Player& player : gameState.players)
+bool send_data(IoThread& ioThread, Connection& connection)
+{
+	if (!connection.outboundQueue.Flush(connection.socket))
 	{
-		if (!player.snake)
-			continue;
+		std::cerr << "failed to send data to player #" << connection.id << " (" << WSAGetLastError() << "), disconnecting..." << std::endl;
+		return false;
+	}
+
+	if (connection.outboundQueue.GetPendingSize() <= ioThread.outboundHighWaterMark)
+		connection.congestedSince.reset();
 
-		Serialize_color(packet, player.snake->GetColor());
-		const std::vector<sf::Vector2i>& snakeBody = player.snake->GetBody();
-		Serialize_u16(packet, snakeBody.size());
-		for (const sf::Vector2i& pos : snakeBody)
+	// On ne surveille la socket en écriture que tant que des données restent en attente
+	bool waitingWritable = !connection.outboundQueue.IsEmpty();
+	if (waitingWritable != connection.waitingWritable)
+	{
+		if (!ioThread.poller.SetWriteInterest(connection.socket, &connection, waitingWritable))
 		{
-			Serialize_i8(packet, pos.x);
-			Serialize_i8(packet, pos.y);
+			std::cerr << "failed to update socket polling of player #" << connection.id << " (" << WSAGetLastError() << "), disconnecting..." << std::endl;
+			return false;
 		}
 
-		snakeCount++;
+		connection.waitingWritable = waitingWritable;
 	}
 
-	Serialize_u8(packet, snakeCountOffset, snakeCount);
+	return true;
+}
+
+void serialize_snake(ByteWriter& packet, const Snake& snake)
+{
+	Serialize_color(packet, snake.GetColor());
+	Serialize_snake_body(packet, snake.GetBody());
+}
 
-	Serialize_u16(packet, sizeOffset, packet.size() - sizeof(std::uint16_t));
+bool spawn_apple(GameState& gameState)
+{
+	if (!gameState.simulation.SpawnApple())
+		return false;
+
+	// La pomme sera envoyée aux joueurs au prochain tick
+	process_simulation_events(gameState);
+	return true;
+}
 
-	for (Player& player : gameState.players)
+void stop_threads(Lobby& lobby)
+{
 	{
-		if (send(player.socket, reinterpret_cast<const char*>(packet.data()), packet.size(), 0) == SOCKET_ERROR)
-			std::cerr << "failed to send data to player #" << player.id << " (" << WSAGetLastError() << ")" << std::endl;
+		// Le verrou garantit qu'aucun thread de simulation ne manque la notification entre son test et son attente
+		std::lock_guard<std::mutex> lock(lobby.stopMutex);
+		lobby.stopRequested = true;
 	}
+	lobby.stopCondition.notify_all();
+
+	for (auto& workerPtr : lobby.workers)
+	{
+		if (workerPtr->thread.joinable())
+			workerPtr->thread.join();
+	}
+
+	for (auto& ioThreadPtr : lobby.ioThreads)
+	{
+		ioThreadPtr->poller.Wakeup();
+		if (ioThreadPtr->thread.joinable())
+			ioThreadPtr->thread.join();
+	}
+}
+
+void tick(GameState& gameState)
+{
+	// Les règles du jeu sont appliquées par la simulation, nous n'avons plus qu'à transmettre ce qui s'est produit
+	gameState.simulation.Tick(gameState.pendingInputs);
+	gameState.pendingInputs.clear();
+
+	process_simulation_events(gameState);
+
+	// Envoi de l'état des serpents à tout le monde (par le thread d'entrées/sorties de la salle)
+	send_game_state(gameState);
+}
+
+void wake_io_thread(IoThread& ioThread)
+{
+	// Seule la première salle à trouver le thread endormi le réveille (appel système), il videra de toute façon les files de toutes ses salles
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (ioThread.sleeping.exchange(false))
+		ioThread.poller.Wakeup();
+}
+
+void wake_room(Lobby& lobby, GameState& gameState)
+{
+	// Seul le premier thread à trouver la salle endormie avance son échéance (voir put_room_to_sleep), puis réveille
+	// les threads de simulation pour qu'ils tiennent compte de la nouvelle échéance
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (!gameState.isSleeping.exchange(false))
+		return;
+
+	lobby.roomScheduler.Advance(get_room_worker(lobby, gameState.id).index, gameState.id, lobby.clock.getElapsedTime());
+
+	{
+		std::lock_guard<std::mutex> lock(lobby.stopMutex);
+		lobby.roomWakeups++;
+	}
+	lobby.stopCondition.notify_all();
+}
+
+void welcome_player(GameState& gameState, unsigned int playerId)
+{
+	Player& player = *gameState.players.emplace_back(std::make_unique<Player>());
+	player.id = playerId;
+
+	// La version du protocole a été acceptée et le joueur a rejoint une salle, il peut entrer en jeu
+	ByteWriter packet(2 + 1 + 5 + 5 + 2 + 1 + 5);
+	std::size_t sizeOffset = BeginMessage(packet, Opcode::S_Welcome);
+	Serialize_varuint(packet, ProtocolVersion);
+	Serialize_varuint(packet, player.id);
+	EndMessage(packet, sizeOffset);
+
+	std::size_t roomSizeOffset = BeginMessage(packet, Opcode::S_RoomJoined);
+	Serialize_varuint(packet, gameState.id);
+	EndMessage(packet, roomSizeOffset);
+
+	push_room_packet(gameState, player.id, MakeSharedPacket(packet), RoomPacketType::Welcome);
+
+	// Ici nous pourrions envoyer un message à tous les clients pour indiquer la connexion d'un nouveau client
+
+	player.snake = &gameState.simulation.AddSnake(player.id);
+
+	process_simulation_events(gameState);
+
+	send_grid(gameState, player);
 }
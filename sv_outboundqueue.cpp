@@ -0,0 +1,135 @@
+﻿#include "sv_outboundqueue.hpp"
+#include <algorithm>
+#include <cassert>
+#include <iterator>
+
+#ifndef _WIN32
+#include <sys/uio.h>
+#endif
+
+SharedPacket MakeSharedPacket(ByteWriter& writer)
+{
+	return std::make_shared<const std::vector<std::uint8_t>>(writer.Release());
+}
+
+OutboundQueue::OutboundQueue() :
+m_frontOffset(0),
+m_pendingSize(0)
+{
+}
+
+bool OutboundQueue::Flush(SOCKET sock)
+{
+	while (!m_packets.empty())
+	{
+		std::size_t batchSize = std::min(m_packets.size(), MaxBatchSize);
+
+#ifdef _WIN32
+		WSABUF buffers[MaxBatchSize];
+		for (std::size_t i = 0; i < batchSize; ++i)
+		{
+			std::size_t offset = (i == 0) ? m_frontOffset : 0;
+			const std::vector<std::uint8_t>& packet = *m_packets[i].packet;
+			buffers[i].buf = const_cast<char*>(reinterpret_cast<const char*>(packet.data() + offset));
+			buffers[i].len = static_cast<ULONG>(packet.size() - offset);
+		}
+
+		DWORD sentSize;
+		if (WSASend(sock, buffers, static_cast<DWORD>(batchSize), &sentSize, 0, nullptr, nullptr) == SOCKET_ERROR)
+			return WSAGetLastError() == WSAEWOULDBLOCK; //< buffer d'envoi plein, la suite sera envoyée lorsque la socket sera à nouveau disponible
+#else
+		iovec buffers[MaxBatchSize];
+		for (std::size_t i = 0; i < batchSize; ++i)
+		{
+			std::size_t offset = (i == 0) ? m_frontOffset : 0;
+			const std::vector<std::uint8_t>& packet = *m_packets[i].packet;
+			buffers[i].iov_base = const_cast<std::uint8_t*>(packet.data() + offset);
+			buffers[i].iov_len = packet.size() - offset;
+		}
+
+		msghdr message = {};
+		message.msg_iov = buffers;
+		message.msg_iovlen = batchSize;
+
+		// MSG_NOSIGNAL évite que l'envoi vers un client déconnecté ne termine le processus (SIGPIPE)
+		ssize_t sentSize = sendmsg(sock, &message, MSG_NOSIGNAL);
+		if (sentSize == -1)
+		{
+			if (errno == EINTR)
+				continue;
+
+			return errno == EAGAIN || errno == EWOULDBLOCK; //< buffer d'envoi plein, la suite sera envoyée lorsque la socket sera à nouveau disponible
+		}
+#endif
+
+		Consume(static_cast<std::size_t>(sentSize));
+	}
+
+	return true;
+}
+
+std::size_t OutboundQueue::GetPendingSize() const
+{
+	return m_pendingSize;
+}
+
+bool OutboundQueue::HasPendingReplaceable() const
+{
+	auto firstRemovable = (m_frontOffset > 0) ? std::next(m_packets.begin()) : m_packets.begin();
+	return std::any_of(firstRemovable, m_packets.end(), [](const Entry& entry)
+	{
+		return entry.replaceable;
+	});
+}
+
+bool OutboundQueue::IsEmpty() const
+{
+	return m_packets.empty();
+}
+
+std::size_t OutboundQueue::Push(SharedPacket packet, bool replaceable)
+{
+	assert(packet && !packet->empty());
+
+	std::size_t removedCount = 0;
+	if (replaceable)
+	{
+		// Le premier paquet a pu être partiellement envoyé, auquel cas il doit l'être entièrement
+		auto firstRemovable = (m_frontOffset > 0) ? std::next(m_packets.begin()) : m_packets.begin();
+		auto it = std::remove_if(firstRemovable, m_packets.end(), [&](const Entry& entry)
+		{
+			if (!entry.replaceable)
+				return false;
+
+			m_pendingSize -= entry.packet->size();
+			removedCount++;
+			return true;
+		});
+		m_packets.erase(it, m_packets.end());
+	}
+
+	m_pendingSize += packet->size();
+	m_packets.push_back({ std::move(packet), replaceable });
+
+	return removedCount;
+}
+
+void OutboundQueue::Consume(std::size_t size)
+{
+	assert(size <= m_pendingSize);
+	m_pendingSize -= size;
+
+	while (size > 0)
+	{
+		std::size_t remaining = m_packets.front().packet->size() - m_frontOffset;
+		if (size < remaining)
+		{
+			m_frontOffset += size;
+			return;
+		}
+
+		size -= remaining;
+		m_frontOffset = 0;
+		m_packets.pop_front();
+	}
+}
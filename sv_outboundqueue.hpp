@@ -0,0 +1,56 @@
+﻿#pragma once
+
+#include "sh_protocol.hpp"
+#include "sh_socket.hpp"
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <vector>
+
+// Paquet encodé une seule fois et partagé (sans copie) entre les files d'envoi de tous les joueurs qui doivent le recevoir
+using SharedPacket = std::shared_ptr<const std::vector<std::uint8_t>>;
+
+// Transforme le contenu d'un ByteWriter (qui est vidé) en paquet partagé
+SharedPacket MakeSharedPacket(ByteWriter& writer);
+
+// La classe OutboundQueue est la file des paquets en attente d'envoi vers un joueur.
+// Les paquets y sont simplement référencés, et sont envoyés par lots en un seul appel système (sendmsg sous Linux, WSASend sous Windows)
+// La socket étant non-bloquante, les données que le client n'a pas encore pu recevoir restent dans la file jusqu'au prochain envoi.
+// Les paquets "remplaçables" (un état complet du jeu par exemple) ne sont gardés qu'en un exemplaire : un nouveau rend le précédent obsolète.
+class OutboundQueue
+{
+public:
+	OutboundQueue();
+
+	// Envoie autant de paquets que possible sans bloquer, renvoie false en cas d'erreur
+	// (si la socket est pleine, les données restantes sont conservées et IsEmpty renvoie false)
+	bool Flush(SOCKET sock);
+
+	// Renvoie le nombre d'octets en attente d'envoi
+	std::size_t GetPendingSize() const;
+
+	// Indique si un paquet remplaçable n'a pas encore commencé à être envoyé (et serait donc retiré par le prochain paquet remplaçable)
+	bool HasPendingReplaceable() const;
+
+	bool IsEmpty() const;
+
+	// Ajoute un paquet à la fin de la file, un paquet remplaçable retire de la file les paquets remplaçables pas encore envoyés
+	// Renvoie le nombre de paquets ainsi retirés
+	std::size_t Push(SharedPacket packet, bool replaceable = false);
+
+private:
+	struct Entry
+	{
+		SharedPacket packet;
+		bool replaceable;
+	};
+
+	static constexpr std::size_t MaxBatchSize = 64; //< nombre maximum de paquets envoyés par appel système
+
+	// Retire `size` octets envoyés du début de la file
+	void Consume(std::size_t size);
+
+	std::deque<Entry> m_packets;
+	std::size_t m_frontOffset; //< nombre d'octets du premier paquet déjà envoyés
+	std::size_t m_pendingSize;
+};
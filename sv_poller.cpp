@@ -0,0 +1,233 @@
+﻿#include "sv_poller.hpp"
+#include <cassert>
+
+#ifdef _WIN32
+
+Poller::Poller() :
+m_wakeupSocket(socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP))
+{
+	if (m_wakeupSocket == INVALID_SOCKET)
+		return;
+
+	// La socket de réveil est connectée à elle-même : un datagramme envoyé par Wakeup la rend lisible
+	sockaddr_in wakeupAddr = {};
+	wakeupAddr.sin_family = AF_INET;
+	wakeupAddr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	wakeupAddr.sin_port = 0;
+
+	int wakeupAddrSize = sizeof(wakeupAddr);
+	if (bind(m_wakeupSocket, reinterpret_cast<sockaddr*>(&wakeupAddr), sizeof(wakeupAddr)) == SOCKET_ERROR ||
+	    getsockname(m_wakeupSocket, reinterpret_cast<sockaddr*>(&wakeupAddr), &wakeupAddrSize) == SOCKET_ERROR ||
+	    connect(m_wakeupSocket, reinterpret_cast<sockaddr*>(&wakeupAddr), sizeof(wakeupAddr)) == SOCKET_ERROR ||
+	    !SetSocketBlocking(m_wakeupSocket, false))
+	{
+		closesocket(m_wakeupSocket);
+		m_wakeupSocket = INVALID_SOCKET;
+		return;
+	}
+
+	Register(m_wakeupSocket, &m_wakeupSocket);
+}
+
+Poller::~Poller()
+{
+	if (m_wakeupSocket != INVALID_SOCKET)
+		closesocket(m_wakeupSocket);
+}
+
+bool Poller::IsValid() const
+{
+	return m_wakeupSocket != INVALID_SOCKET;
+}
+
+bool Poller::Register(SOCKET sock, void* userdata)
+{
+	auto& descriptor = m_descriptors.emplace_back();
+	descriptor.fd = sock;
+	descriptor.events = POLLRDNORM;
+	descriptor.revents = 0;
+
+	m_userdata.push_back(userdata);
+
+	return true;
+}
+
+bool Poller::SetWriteInterest(SOCKET sock, void* /*userdata*/, bool enable)
+{
+	for (WSAPOLLFD& descriptor : m_descriptors)
+	{
+		if (descriptor.fd != sock)
+			continue;
+
+		// WSAPoll étant level-triggered, une socket surveillée en écriture serait signalée en permanence
+		// tant que son buffer d'envoi n'est pas plein : on ne la surveille que lorsque des données sont en attente
+		descriptor.events = (enable) ? POLLRDNORM | POLLWRNORM : POLLRDNORM;
+		return true;
+	}
+
+	assert(!"socket is not registered");
+	return false;
+}
+
+void Poller::Unregister(SOCKET sock)
+{
+	for (std::size_t i = 0; i < m_descriptors.size(); ++i)
+	{
+		if (m_descriptors[i].fd != sock)
+			continue;
+
+		// L'ordre des descripteurs n'a pas d'importance, on remplace celui-ci par le dernier
+		m_descriptors[i] = m_descriptors.back();
+		m_descriptors.pop_back();
+
+		m_userdata[i] = m_userdata.back();
+		m_userdata.pop_back();
+		return;
+	}
+
+	assert(!"socket is not registered");
+}
+
+bool Poller::Wait(std::vector<PollEvent>& events, int timeout)
+{
+	events.clear();
+
+	int activeSockets = WSAPoll(m_descriptors.data(), static_cast<ULONG>(m_descriptors.size()), timeout);
+	if (activeSockets == SOCKET_ERROR)
+		return false;
+
+	for (std::size_t i = 0; i < m_descriptors.size() && events.size() < static_cast<std::size_t>(activeSockets); ++i)
+	{
+		WSAPOLLFD& descriptor = m_descriptors[i];
+		if (descriptor.revents == 0)
+			continue;
+
+		if (descriptor.fd == m_wakeupSocket)
+		{
+			// On vide la socket de réveil (plusieurs réveils ont pu s'accumuler), sans renvoyer d'événement
+			char wakeupData[16];
+			while (recv(m_wakeupSocket, wakeupData, sizeof(wakeupData), 0) > 0);
+
+			descriptor.revents = 0;
+			activeSockets--;
+			continue;
+		}
+
+		auto& event = events.emplace_back();
+		event.userdata = m_userdata[i];
+		event.disconnected = (descriptor.revents & (POLLERR | POLLHUP)) != 0;
+		event.readable = (descriptor.revents & POLLRDNORM) != 0;
+		event.writable = (descriptor.revents & POLLWRNORM) != 0;
+
+		descriptor.revents = 0;
+	}
+
+	return true;
+}
+
+void Poller::Wakeup()
+{
+	char wakeupData = 0;
+	send(m_wakeupSocket, &wakeupData, sizeof(wakeupData), 0);
+}
+
+#else
+
+Poller::Poller() :
+m_epoll(epoll_create1(EPOLL_CLOEXEC)),
+m_wakeupFd(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK))
+{
+	if (m_epoll == -1 || m_wakeupFd == -1)
+		return;
+
+	if (!Register(m_wakeupFd, &m_wakeupFd))
+	{
+		close(m_wakeupFd);
+		m_wakeupFd = -1;
+	}
+}
+
+Poller::~Poller()
+{
+	if (m_wakeupFd != -1)
+		close(m_wakeupFd);
+
+	if (m_epoll != -1)
+		close(m_epoll);
+}
+
+bool Poller::IsValid() const
+{
+	return m_epoll != -1 && m_wakeupFd != -1;
+}
+
+bool Poller::Register(SOCKET sock, void* userdata)
+{
+	epoll_event event;
+	event.events = EPOLLIN | EPOLLRDHUP | EPOLLET;
+	event.data.ptr = userdata;
+
+	if (epoll_ctl(m_epoll, EPOLL_CTL_ADD, sock, &event) == -1)
+		return false;
+
+	m_readyEvents.resize(m_readyEvents.size() + 1);
+	return true;
+}
+
+bool Poller::SetWriteInterest(SOCKET sock, void* userdata, bool enable)
+{
+	// La modification réarme également la socket : si elle est déjà disponible en écriture, un événement sera signalé
+	epoll_event event;
+	event.events = EPOLLIN | EPOLLRDHUP | EPOLLET;
+	if (enable)
+		event.events |= EPOLLOUT;
+
+	event.data.ptr = userdata;
+
+	return epoll_ctl(m_epoll, EPOLL_CTL_MOD, sock, &event) == 0;
+}
+
+void Poller::Unregister(SOCKET sock)
+{
+	[[maybe_unused]] int result = epoll_ctl(m_epoll, EPOLL_CTL_DEL, sock, nullptr);
+	assert(result == 0);
+
+	m_readyEvents.pop_back();
+}
+
+bool Poller::Wait(std::vector<PollEvent>& events, int timeout)
+{
+	events.clear();
+
+	assert(!m_readyEvents.empty());
+	int activeSockets = epoll_wait(m_epoll, m_readyEvents.data(), static_cast<int>(m_readyEvents.size()), timeout);
+	if (activeSockets == -1)
+		return errno == EINTR;
+
+	for (int i = 0; i < activeSockets; ++i)
+	{
+		const epoll_event& readyEvent = m_readyEvents[i];
+		if (readyEvent.data.ptr == &m_wakeupFd)
+		{
+			// On remet le compteur de l'eventfd à zéro (plusieurs réveils ont pu s'accumuler), sans renvoyer d'événement
+			eventfd_t wakeupCount;
+			eventfd_read(m_wakeupFd, &wakeupCount);
+			continue;
+		}
+
+		auto& event = events.emplace_back();
+		event.userdata = readyEvent.data.ptr;
+		event.disconnected = (readyEvent.events & (EPOLLERR | EPOLLHUP)) != 0;
+		event.readable = (readyEvent.events & (EPOLLIN | EPOLLRDHUP)) != 0;
+		event.writable = (readyEvent.events & EPOLLOUT) != 0;
+	}
+
+	return true;
+}
+
+void Poller::Wakeup()
+{
+	eventfd_write(m_wakeupFd, 1);
+}
+
+#endif
@@ -0,0 +1,75 @@
+﻿#pragma once
+
+#include "sh_socket.hpp"
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#endif
+
+// Événement remonté par le Poller pour une socket surveillée
+struct PollEvent
+{
+	void* userdata; //< pointeur associé à la socket lors de son enregistrement
+	bool disconnected; //< la socket a été fermée ou est en erreur
+	bool readable; //< des données (ou une connexion en attente pour une socket serveur) sont disponibles
+	bool writable; //< de la place s'est libérée dans le buffer d'envoi (uniquement si la surveillance en écriture est active)
+};
+
+// La classe Poller permet de surveiller un ensemble de sockets et d'attendre qu'une ou plusieurs d'entre elles soient actives.
+// Chaque socket est enregistrée une seule fois avec un pointeur utilisateur (typiquement le joueur correspondant),
+// qui est directement renvoyé lors des événements : il n'y a donc pas besoin de rechercher à qui appartient une socket.
+//
+// Sous Linux, on utilise epoll en mode edge-triggered : un événement n'est signalé qu'une fois lorsque des données arrivent,
+// il faut donc lire (ou accepter) jusqu'à obtenir WSAEWOULDBLOCK. Le coût d'une attente dépend du nombre de sockets actives.
+// Sous Windows, on utilise WSAPoll (level-triggered) avec un tableau de descripteurs conservé d'une attente à l'autre.
+//
+// Un Poller n'est utilisé que par un seul thread, à l'exception de Wakeup qui permet à un autre thread d'interrompre une attente
+// (par exemple pour lui confier une nouvelle socket) : un eventfd sous Linux, une socket UDP connectée à elle-même sous Windows.
+class Poller
+{
+public:
+#ifdef _WIN32
+	static constexpr bool EdgeTriggered = false;
+#else
+	static constexpr bool EdgeTriggered = true;
+#endif
+
+	Poller();
+	Poller(const Poller&) = delete;
+	~Poller();
+
+	// Indique si le Poller a pu être initialisé
+	bool IsValid() const;
+
+	// Commence la surveillance d'une socket en lecture, renvoie false en cas d'erreur
+	bool Register(SOCKET sock, void* userdata);
+
+	// Active ou désactive la surveillance en écriture d'une socket déjà enregistrée, renvoie false en cas d'erreur
+	bool SetWriteInterest(SOCKET sock, void* userdata, bool enable);
+
+	// Arrête la surveillance d'une socket (à faire avant de la fermer)
+	void Unregister(SOCKET sock);
+
+	// Attend au plus timeout millisecondes (-1 pour une attente infinie) qu'une socket s'active
+	// et remplit events avec les sockets actives, renvoie false en cas d'erreur
+	// (events peut être vide si l'attente a été interrompue par Wakeup ou a atteint son délai)
+	bool Wait(std::vector<PollEvent>& events, int timeout);
+
+	// Interrompt l'attente en cours (ou la prochaine), peut être appelée depuis n'importe quel thread
+	void Wakeup();
+
+	Poller& operator=(const Poller&) = delete;
+
+private:
+#ifdef _WIN32
+	std::vector<WSAPOLLFD> m_descriptors;
+	std::vector<void*> m_userdata;
+	SOCKET m_wakeupSocket;
+#else
+	std::vector<epoll_event> m_readyEvents;
+	int m_epoll;
+	int m_wakeupFd;
+#endif
+};
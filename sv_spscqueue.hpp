@@ -0,0 +1,86 @@
+﻿#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+// La classe SpscQueue est une file de taille fixe et sans verrou entre un unique thread producteur et un unique thread consommateur
+// (un thread peut en remplacer un autre dans l'un de ces rôles, à condition qu'une synchronisation les sépare, un mutex par exemple).
+// Les éléments sont rangés dans un tampon circulaire : le producteur n'écrit que m_tail et le consommateur que m_head,
+// chacun lisant l'indice de l'autre pour savoir s'il reste des éléments (ou de la place), sans jamais attendre.
+template<typename T>
+class SpscQueue
+{
+public:
+	// La capacité est arrondie à la puissance de deux supérieure
+	explicit SpscQueue(std::size_t capacity);
+	SpscQueue(const SpscQueue&) = delete;
+
+	// (consommateur) Indique si la file est vide
+	bool IsEmpty() const;
+
+	// (consommateur) Retire le plus ancien élément de la file, renvoie false si celle-ci est vide
+	bool TryPop(T& value);
+
+	// (producteur) Ajoute un élément à la fin de la file, renvoie false si celle-ci est pleine (value n'est alors pas déplacé)
+	bool TryPush(T&& value);
+
+	SpscQueue& operator=(const SpscQueue&) = delete;
+
+private:
+	// Les deux indices sont sur des lignes de cache différentes, pour que le producteur et le consommateur ne se gênent pas
+	static constexpr std::size_t CacheLineSize = 64;
+
+	std::unique_ptr<T[]> m_buffer;
+	std::size_t m_mask;
+	alignas(CacheLineSize) std::atomic<std::size_t> m_head; //< prochain élément à lire
+	alignas(CacheLineSize) std::atomic<std::size_t> m_tail; //< prochain emplacement à écrire
+};
+
+template<typename T>
+SpscQueue<T>::SpscQueue(std::size_t capacity) :
+m_head(0),
+m_tail(0)
+{
+	std::size_t bufferSize = 1;
+	while (bufferSize < capacity)
+		bufferSize *= 2;
+
+	m_buffer = std::make_unique<T[]>(bufferSize);
+	m_mask = bufferSize - 1;
+}
+
+template<typename T>
+bool SpscQueue<T>::IsEmpty() const
+{
+	return m_head.load(std::memory_order_relaxed) == m_tail.load(std::memory_order_acquire);
+}
+
+template<typename T>
+bool SpscQueue<T>::TryPop(T& value)
+{
+	std::size_t head = m_head.load(std::memory_order_relaxed);
+	if (head == m_tail.load(std::memory_order_acquire))
+		return false;
+
+	// L'emplacement est vidé pour ne pas garder de ressource (un paquet partagé par exemple) plus longtemps que nécessaire
+	T& slot = m_buffer[head & m_mask];
+	value = std::move(slot);
+	slot = T();
+
+	m_head.store(head + 1, std::memory_order_release);
+	return true;
+}
+
+template<typename T>
+bool SpscQueue<T>::TryPush(T&& value)
+{
+	std::size_t tail = m_tail.load(std::memory_order_relaxed);
+	if (tail - m_head.load(std::memory_order_acquire) > m_mask)
+		return false;
+
+	m_buffer[tail & m_mask] = std::move(value);
+
+	m_tail.store(tail + 1, std::memory_order_release);
+	return true;
+}
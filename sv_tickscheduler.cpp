@@ -0,0 +1,48 @@
+﻿#include "sv_tickscheduler.hpp"
+#include <algorithm>
+
+TickScheduler::TickScheduler(const sf::Time& interval, unsigned int maxCatchUpTicks) :
+m_interval(interval),
+m_nextTick(interval),
+m_maxCatchUpTicks(maxCatchUpTicks)
+{
+}
+
+const sf::Time& TickScheduler::GetNextTick() const
+{
+	return m_nextTick;
+}
+
+auto TickScheduler::GetStats() const -> const Stats&
+{
+	return m_stats;
+}
+
+unsigned int TickScheduler::Update(const sf::Time& now)
+{
+	if (now < m_nextTick)
+		return 0;
+
+	// Nombre de ticks dont l'échéance est passée, celui prévu compris
+	std::uint64_t dueTicks = 1 + (now - m_nextTick).asMicroseconds() / m_interval.asMicroseconds();
+	std::uint64_t tickCount = std::min<std::uint64_t>(dueTicks, 1 + m_maxCatchUpTicks);
+
+	m_stats.executedTicks += tickCount;
+	m_stats.lateTicks += tickCount - 1;
+	m_stats.droppedTicks += dueTicks - tickCount;
+
+	// Les ticks abandonnés sont sautés : le prochain tick reste aligné sur le pas de temps fixe
+	m_nextTick += m_interval * static_cast<sf::Int64>(dueTicks);
+
+	return static_cast<unsigned int>(tickCount);
+}
+
+void TickScheduler::ResetStats()
+{
+	m_stats = Stats{};
+}
+
+void TickScheduler::Restart(const sf::Time& now)
+{
+	m_nextTick = now + m_interval;
+}
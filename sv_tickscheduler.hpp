@@ -0,0 +1,40 @@
+﻿#pragma once
+
+#include <SFML/System/Time.hpp>
+#include <cstdint>
+
+// La classe TickScheduler décide combien de mises à jour (ticks) du jeu exécuter à un instant donné, avec un pas de temps fixe.
+// Si le serveur a pris du retard (tick trop long, machine surchargée), les ticks en retard sont rattrapés immédiatement,
+// dans la limite de maxCatchUpTicks : au-delà, les ticks sont abandonnés et comptabilisés, plutôt que de laisser la simulation
+// dériver par rapport à l'horloge puis avancer par à-coups.
+class TickScheduler
+{
+public:
+	struct Stats
+	{
+		std::uint64_t droppedTicks = 0; //< ticks abandonnés car le retard dépassait la limite de rattrapage
+		std::uint64_t executedTicks = 0; //< ticks exécutés (à l'heure ou non)
+		std::uint64_t lateTicks = 0; //< ticks exécutés en rattrapage, alors que le tick suivant était déjà dû
+	};
+
+	TickScheduler(const sf::Time& interval, unsigned int maxCatchUpTicks);
+
+	// Renvoie l'échéance du prochain tick
+	const sf::Time& GetNextTick() const;
+
+	const Stats& GetStats() const;
+
+	// Renvoie le nombre de ticks à exécuter maintenant (zéro si le prochain tick n'est pas encore dû) et prévoit le suivant
+	unsigned int Update(const sf::Time& now);
+
+	void ResetStats();
+
+	// Reprend les ticks après une interruption : le prochain tick est prévu un pas de temps après now, sans rattraper ceux manqués
+	void Restart(const sf::Time& now);
+
+private:
+	Stats m_stats;
+	sf::Time m_interval;
+	sf::Time m_nextTick;
+	unsigned int m_maxCatchUpTicks;
+};
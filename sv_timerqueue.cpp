@@ -0,0 +1,42 @@
+﻿#include "sv_timerqueue.hpp"
+#include <algorithm>
+
+void TimerQueue::Process(const sf::Time& now)
+{
+	while (!m_timers.empty() && m_timers.front().deadline <= now)
+	{
+		std::pop_heap(m_timers.begin(), m_timers.end(), &TimerQueue::Compare);
+		Timer timer = std::move(m_timers.back());
+		m_timers.pop_back();
+
+		if (std::optional<sf::Time> nextDeadline = timer.callback(timer.deadline, now))
+			Schedule(*nextDeadline, std::move(timer.callback));
+	}
+}
+
+void TimerQueue::Schedule(const sf::Time& deadline, Callback callback)
+{
+	Timer& timer = m_timers.emplace_back();
+	timer.deadline = deadline;
+	timer.sequence = m_nextSequence++;
+	timer.callback = std::move(callback);
+
+	std::push_heap(m_timers.begin(), m_timers.end(), &TimerQueue::Compare);
+}
+
+std::optional<sf::Time> TimerQueue::GetNextDeadline() const
+{
+	if (m_timers.empty())
+		return std::nullopt;
+
+	return m_timers.front().deadline;
+}
+
+bool TimerQueue::Compare(const Timer& lhs, const Timer& rhs)
+{
+	// std::push_heap construit un tas dont le sommet est le plus grand élément, on inverse donc la comparaison
+	if (lhs.deadline != rhs.deadline)
+		return lhs.deadline > rhs.deadline;
+
+	return lhs.sequence > rhs.sequence;
+}
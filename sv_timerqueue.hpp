@@ -0,0 +1,41 @@
+﻿#pragma once
+
+#include <SFML/System/Time.hpp>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <vector>
+
+// La classe TimerQueue garde une liste d'échéances (triées dans un tas, la plus proche étant toujours au sommet)
+// et permet de savoir combien de temps on peut attendre avant la prochaine, ce qui évite de se réveiller inutilement.
+class TimerQueue
+{
+public:
+	// Fonction appelée à l'échéance, avec l'heure prévue et l'heure réelle de l'appel.
+	// Elle peut renvoyer une nouvelle échéance pour être rappelée plus tard (timer périodique)
+	using Callback = std::function<std::optional<sf::Time>(const sf::Time& deadline, const sf::Time& now)>;
+
+	TimerQueue() = default;
+
+	// Appelle toutes les fonctions dont l'échéance est passée, dans l'ordre de leurs échéances
+	void Process(const sf::Time& now);
+
+	// Programme un appel à une échéance donnée
+	void Schedule(const sf::Time& deadline, Callback callback);
+
+	// Renvoie la prochaine échéance, s'il y en a une
+	std::optional<sf::Time> GetNextDeadline() const;
+
+private:
+	struct Timer
+	{
+		sf::Time deadline;
+		std::uint64_t sequence; //< permet de conserver l'ordre de programmation pour des échéances identiques
+		Callback callback;
+	};
+
+	static bool Compare(const Timer& lhs, const Timer& rhs);
+
+	std::vector<Timer> m_timers;
+	std::uint64_t m_nextSequence = 0;
+};
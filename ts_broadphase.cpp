@@ -0,0 +1,113 @@
+﻿#include "ts_tests.hpp"
+#include "sh_broadphase.hpp"
+#include "sh_random.hpp"
+#include <algorithm>
+#include <tuple>
+#include <vector>
+
+namespace
+{
+	bool IsSameCollision(const SnakeCollision& lhs, const SnakeCollision& rhs)
+	{
+		return std::tie(lhs.snakeId, lhs.otherId, lhs.type) == std::tie(rhs.snakeId, rhs.otherId, rhs.type);
+	}
+
+	bool IsCollisionLess(const SnakeCollision& lhs, const SnakeCollision& rhs)
+	{
+		return std::tie(lhs.snakeId, lhs.otherId, lhs.type) < std::tie(rhs.snakeId, rhs.otherId, rhs.type);
+	}
+
+	bool AreSameCollisions(const std::vector<SnakeCollision>& lhs, const std::vector<SnakeCollision>& rhs)
+	{
+		return std::equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(), &IsSameCollision);
+	}
+
+	// Serpents aux corps tirés au hasard sur un petit terrain (pour provoquer de nombreuses collisions, y compris d'un serpent avec lui-même)
+	std::vector<Snake> BuildSnakes(RandomGenerator& random, std::size_t snakeCount, int boardSize)
+	{
+		const sf::Vector2i directions[] = { { 1, 0 }, { -1, 0 }, { 0, 1 }, { 0, -1 } };
+
+		std::vector<Snake> snakes;
+		snakes.reserve(snakeCount);
+		for (std::size_t i = 0; i < snakeCount; ++i)
+		{
+			std::vector<sf::Vector2i> body(random.GenerateBelow(30) + 3);
+			body[0] = sf::Vector2i(static_cast<int>(random.GenerateBelow(boardSize)), static_cast<int>(random.GenerateBelow(boardSize)));
+			for (std::size_t j = 1; j < body.size(); ++j)
+				body[j] = body[j - 1] + directions[random.GenerateBelow(4)];
+
+			snakes.emplace_back(std::move(body), sf::Vector2i(1, 0), Color{});
+		}
+
+		return snakes;
+	}
+
+	// Test de chaque tête contre chaque serpent, à l'aide de Snake::TestCollision
+	std::vector<SnakeCollision> DetectBruteForce(std::vector<Snake>& snakes, const std::vector<unsigned int>& snakeIds)
+	{
+		std::vector<SnakeCollision> collisions;
+		for (std::size_t i = 0; i < snakes.size(); ++i)
+		{
+			sf::Vector2i headPos = snakes[i].GetHeadPosition();
+			for (std::size_t j = 0; j < snakes.size(); ++j)
+			{
+				if (i == j)
+				{
+					if (snakes[j].TestCollision(headPos, false))
+						collisions.push_back({ snakeIds[i], snakeIds[j], CollisionType::Self });
+
+					continue;
+				}
+
+				if (snakes[j].GetHeadPosition() == headPos)
+					collisions.push_back({ snakeIds[i], snakeIds[j], CollisionType::Head });
+
+				if (snakes[j].TestCollision(headPos, false))
+					collisions.push_back({ snakeIds[i], snakeIds[j], CollisionType::Body });
+			}
+		}
+
+		std::sort(collisions.begin(), collisions.end(), &IsCollisionLess);
+		return collisions;
+	}
+}
+
+void TestBroadphase()
+{
+	// Plusieurs threads, pour que la recherche soit découpée en plages dès que les serpents sont assez nombreux
+	TaskPool taskPool(4);
+
+	RandomGenerator random(90);
+	for (std::size_t i = 0; i < 300; ++i)
+	{
+		std::size_t snakeCount = (i % 3 == 0) ? random.GenerateBelow(600) + 1 : random.GenerateBelow(40) + 1;
+		int boardSize = static_cast<int>(random.GenerateBelow(60)) + 8;
+		std::vector<Snake> snakes = BuildSnakes(random, snakeCount, boardSize);
+
+		// Identifiants mélangés, le résultat ne devant pas dépendre de l'ordre d'ajout
+		std::vector<unsigned int> snakeIds(snakeCount);
+		for (std::size_t j = 0; j < snakeCount; ++j)
+			snakeIds[j] = static_cast<unsigned int>(j + 1);
+
+		for (std::size_t j = snakeCount - 1; j > 0; --j)
+			std::swap(snakeIds[j], snakeIds[random.GenerateBelow(static_cast<std::uint32_t>(j + 1))]);
+
+		std::vector<SnakeCollision> expected = DetectBruteForce(snakes, snakeIds);
+
+		CollisionBroadphase broadphase;
+		for (std::size_t j = 0; j < snakeCount; ++j)
+			broadphase.AddSnake(snakeIds[j], snakes[j]);
+
+		std::vector<SnakeCollision> collisions;
+		broadphase.Detect(collisions);
+		TEST_CHECK(std::is_sorted(collisions.begin(), collisions.end(), &IsCollisionLess));
+
+		std::vector<SnakeCollision> parallelCollisions;
+		broadphase.Detect(parallelCollisions, &taskPool);
+		TEST_CHECK(AreSameCollisions(parallelCollisions, collisions));
+
+		// Le broadphase signale chaque pièce percutée, alors que TestCollision s'arrête à la première
+		collisions.erase(std::unique(collisions.begin(), collisions.end(), &IsSameCollision), collisions.end());
+		TEST_CHECK(AreSameCollisions(collisions, expected));
+	}
+}
@@ -0,0 +1,69 @@
+﻿#include "ts_tests.hpp"
+#include "sh_grid.hpp"
+#include "sh_random.hpp"
+#include <vector>
+
+void TestGridBitPlanes()
+{
+	// Les largeurs couvrent une ligne plus courte, aussi longue et plus longue qu'un mot de 64 cellules
+	RandomGenerator random(78);
+	for (int width : { 1, 5, 63, 64, 65, 130, 200 })
+	{
+		const int height = 17;
+
+		// Grille de référence, une CellType par cellule
+		std::vector<CellType> cells(static_cast<std::size_t>(width) * height, CellType::None);
+		Grid grid(width, height);
+
+		for (int i = 0; i < width * height * 2; ++i)
+		{
+			int x = static_cast<int>(random.GenerateBelow(width));
+			int y = static_cast<int>(random.GenerateBelow(height));
+			CellType cellType = static_cast<CellType>(random.GenerateBelow(3));
+
+			grid.SetCell(x, y, cellType);
+			cells[y * width + x] = cellType;
+		}
+
+		std::size_t appleCount = 0;
+		std::size_t wallCount = 0;
+		for (int y = 0; y < height; ++y)
+		{
+			for (int x = 0; x < width; ++x)
+			{
+				CellType cellType = cells[y * width + x];
+				TEST_CHECK(grid.GetCell(x, y) == cellType);
+
+				if (cellType == CellType::Apple)
+					appleCount++;
+				else if (cellType == CellType::Wall)
+					wallCount++;
+
+				// Première cellule vide de la ligne à partir de x
+				int emptyX = x;
+				while (emptyX < width && cells[y * width + emptyX] != CellType::None)
+					emptyX++;
+
+				TEST_CHECK(grid.FindEmptyCellInRow(x, y) == ((emptyX < width) ? emptyX : -1));
+			}
+		}
+
+		TEST_CHECK(grid.CountCells(CellType::Apple) == appleCount);
+		TEST_CHECK(grid.CountCells(CellType::Wall) == wallCount);
+
+		// ForEachCell doit visiter chaque cellule non-vide une seule fois, ligne par ligne
+		std::size_t visitedCount = 0;
+		int lastIndex = -1;
+		grid.ForEachCell([&](int x, int y, CellType cellType)
+		{
+			int index = y * width + x;
+			TEST_CHECK(index > lastIndex);
+			TEST_CHECK(cellType != CellType::None && cells[index] == cellType);
+
+			lastIndex = index;
+			visitedCount++;
+		});
+
+		TEST_CHECK(visitedCount == appleCount + wallCount);
+	}
+}
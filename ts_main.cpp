@@ -0,0 +1,67 @@
+﻿#include "ts_tests.hpp"
+#include <cstdlib>
+#include <iostream>
+#include <string_view>
+
+namespace
+{
+	struct Test
+	{
+		const char* name;
+		void (*function)();
+	};
+
+	// Les tests sont lancés dans cet ordre, ou individuellement en passant leur nom en paramètre
+	const Test Tests[] = {
+		{ "grid_bit_planes", &TestGridBitPlanes },
+		{ "broadphase", &TestBroadphase },
+		{ "snake_body_round_trip", &TestSnakeBodyRoundTrip },
+		{ "snake_body_positions_fallback", &TestSnakeBodyPositionsFallback },
+		{ "snake_body_truncated", &TestSnakeBodyTruncated },
+		{ "simulation_determinism", &TestSimulationDeterminism }
+	};
+
+	// Au-delà, les échecs d'un même test sont seulement comptés (un test en boucle pouvant échouer des milliers de fois)
+	constexpr std::size_t MaxReportedFailures = 10;
+
+	std::size_t s_failureCount = 0;
+}
+
+void ReportTestFailure(const char* expression, const char* file, int line)
+{
+	if (s_failureCount++ < MaxReportedFailures)
+		std::cerr << file << ":" << line << ": check failed: " << expression << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+	std::size_t testCount = 0;
+	std::size_t failedTestCount = 0;
+	for (const Test& test : Tests)
+	{
+		if (argc > 1 && std::string_view(argv[1]) != test.name)
+			continue;
+
+		s_failureCount = 0;
+		test.function();
+
+		if (s_failureCount > 0)
+		{
+			std::cout << "[FAIL] " << test.name << " (" << s_failureCount << " failed checks)" << std::endl;
+			failedTestCount++;
+		}
+		else
+			std::cout << "[ OK ] " << test.name << std::endl;
+
+		testCount++;
+	}
+
+	if (testCount == 0)
+	{
+		std::cerr << "unknown test " << argv[1] << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	std::cout << testCount - failedTestCount << "/" << testCount << " tests passed" << std::endl;
+	return (failedTestCount == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,132 @@
+﻿#include "ts_tests.hpp"
+#include "sh_protocol.hpp"
+#include "sh_random.hpp"
+#include <vector>
+
+namespace
+{
+	const sf::Vector2i Directions[] = { { 1, 0 }, { -1, 0 }, { 0, 1 }, { 0, -1 } };
+
+	// Corps dont chaque pièce est voisine de la précédente (encodé par une chaîne de directions), pouvant se recouper
+	std::vector<sf::Vector2i> BuildChainBody(RandomGenerator& random, std::size_t length)
+	{
+		std::vector<sf::Vector2i> body(length);
+		body[0] = sf::Vector2i(static_cast<int>(random.GenerateBelow(1000)) + 500, static_cast<int>(random.GenerateBelow(1000)) + 500);
+		for (std::size_t i = 1; i < length; ++i)
+			body[i] = body[i - 1] + Directions[random.GenerateBelow(4)];
+
+		return body;
+	}
+
+	// Corps dont les pièces sont placées au hasard (encodé position par position)
+	std::vector<sf::Vector2i> BuildScatteredBody(RandomGenerator& random, std::size_t length)
+	{
+		std::vector<sf::Vector2i> body(length);
+		for (sf::Vector2i& position : body)
+			position = sf::Vector2i(static_cast<int>(random.GenerateBelow(300)), static_cast<int>(random.GenerateBelow(300)));
+
+		return body;
+	}
+
+	// Un serpent ayant toujours au moins trois pièces, les corps testés ne sont jamais plus courts
+	std::vector<std::uint8_t> SerializeBody(const std::vector<sf::Vector2i>& body)
+	{
+		Snake snake(body, sf::Vector2i(1, 0), Color{});
+
+		ByteWriter writer;
+		Serialize_snake_body(writer, snake.GetBody());
+
+		return writer.Release();
+	}
+
+	void CheckRoundTrip(const std::vector<sf::Vector2i>& body)
+	{
+		std::vector<std::uint8_t> data = SerializeBody(body);
+
+		ByteReader reader(data.data(), data.size());
+		std::vector<sf::Vector2i> result = Unserialize_snake_body(reader);
+
+		TEST_CHECK(!reader.HasError());
+		TEST_CHECK(reader.GetRemaining() == 0);
+		TEST_CHECK(result == body);
+	}
+
+	// Taille de l'en-tête (longueur, position de la tête et encodage)
+	std::size_t GetHeaderSize(const std::vector<sf::Vector2i>& body)
+	{
+		return GetVaruintSize(static_cast<std::uint32_t>(body.size())) + GetVaruintSize(body[0].x) + GetVaruintSize(body[0].y) + 1;
+	}
+}
+
+void TestSnakeBodyRoundTrip()
+{
+	RandomGenerator random(12);
+	for (std::size_t i = 0; i < 2000; ++i)
+	{
+		// Les petites longueurs couvrent tous les cas de complétion du dernier octet de la chaîne
+		std::size_t length = (i < 16) ? i + 3 : random.GenerateBelow(400) + 3;
+		std::vector<sf::Vector2i> body = BuildChainBody(random, length);
+
+		CheckRoundTrip(body);
+
+		// Deux bits par pièce suivant la tête
+		TEST_CHECK(SerializeBody(body).size() == GetHeaderSize(body) + (length - 1 + 3) / 4);
+	}
+}
+
+void TestSnakeBodyPositionsFallback()
+{
+	RandomGenerator random(34);
+	for (std::size_t i = 0; i < 2000; ++i)
+	{
+		std::size_t length = random.GenerateBelow(200) + 3;
+		std::vector<sf::Vector2i> body = BuildScatteredBody(random, length);
+
+		// Une seule pièce éloignée de ses voisines suffit à passer à l'encodage par positions
+		if (i % 2 == 0)
+		{
+			body = BuildChainBody(random, length);
+			body[random.GenerateBelow(static_cast<std::uint32_t>(length - 1)) + 1] += sf::Vector2i(5, 0);
+		}
+
+		CheckRoundTrip(body);
+
+		std::size_t expectedSize = GetHeaderSize(body);
+		for (std::size_t j = 1; j < length; ++j)
+			expectedSize += GetVaruintSize(body[j].x) + GetVaruintSize(body[j].y);
+
+		TEST_CHECK(SerializeBody(body).size() == expectedSize);
+	}
+}
+
+void TestSnakeBodyTruncated()
+{
+	RandomGenerator random(56);
+	for (std::size_t i = 0; i < 200; ++i)
+	{
+		std::size_t length = random.GenerateBelow(100) + 3;
+		std::vector<sf::Vector2i> body = (i % 2 == 0) ? BuildChainBody(random, length) : BuildScatteredBody(random, length);
+		std::vector<std::uint8_t> data = SerializeBody(body);
+
+		// Chaque troncature du message doit être détectée, sans renvoyer de corps partiel
+		for (std::size_t size = 0; size < data.size(); ++size)
+		{
+			ByteReader reader(data.data(), size);
+			std::vector<sf::Vector2i> result = Unserialize_snake_body(reader);
+
+			TEST_CHECK(reader.HasError());
+			TEST_CHECK(result.empty());
+		}
+	}
+
+	// Un corps vide ou un encodage inconnu sont invalides
+	std::uint8_t emptyBody[] = { 0, 1, 1, 0 };
+	ByteReader emptyReader(emptyBody, sizeof(emptyBody));
+	TEST_CHECK(Unserialize_snake_body(emptyReader).empty());
+	TEST_CHECK(emptyReader.HasError());
+
+	std::uint8_t unknownEncoding[] = { 1, 1, 1, 2 };
+	ByteReader unknownReader(unknownEncoding, sizeof(unknownEncoding));
+	TEST_CHECK(Unserialize_snake_body(unknownReader).empty());
+	TEST_CHECK(unknownReader.HasError());
+}
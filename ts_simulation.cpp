@@ -0,0 +1,149 @@
+﻿#include "ts_tests.hpp"
+#include "sh_random.hpp"
+#include "sh_simulation.hpp"
+#include <tuple>
+#include <vector>
+
+namespace
+{
+	bool AreSameEvents(const std::vector<SimulationEvent>& lhs, const std::vector<SimulationEvent>& rhs)
+	{
+		if (lhs.size() != rhs.size())
+			return false;
+
+		for (std::size_t i = 0; i < lhs.size(); ++i)
+		{
+			const SimulationEvent& lhsEvent = lhs[i];
+			const SimulationEvent& rhsEvent = rhs[i];
+			if (std::tie(lhsEvent.type, lhsEvent.snakeId, lhsEvent.otherId, lhsEvent.collisionType, lhsEvent.position) !=
+			    std::tie(rhsEvent.type, rhsEvent.snakeId, rhsEvent.otherId, rhsEvent.collisionType, rhsEvent.position))
+				return false;
+		}
+
+		return true;
+	}
+
+	bool AreSameGrids(const Grid& lhs, const Grid& rhs)
+	{
+		if (lhs.CountCells(CellType::Apple) != rhs.CountCells(CellType::Apple) || lhs.CountCells(CellType::Wall) != rhs.CountCells(CellType::Wall))
+			return false;
+
+		for (int y = 0; y < lhs.GetHeight(); ++y)
+		{
+			for (int x = 0; x < lhs.GetWidth(); ++x)
+			{
+				if (lhs.GetCell(x, y) != rhs.GetCell(x, y))
+					return false;
+			}
+		}
+
+		return true;
+	}
+
+	bool AreSameSnakes(const std::map<unsigned int, Snake>& lhs, const std::map<unsigned int, Snake>& rhs)
+	{
+		if (lhs.size() != rhs.size())
+			return false;
+
+		for (auto lhsIt = lhs.begin(), rhsIt = rhs.begin(); lhsIt != lhs.end(); ++lhsIt, ++rhsIt)
+		{
+			if (lhsIt->first != rhsIt->first)
+				return false;
+
+			SnakeBody lhsBody = lhsIt->second.GetBody();
+			SnakeBody rhsBody = rhsIt->second.GetBody();
+			if (lhsBody.size() != rhsBody.size())
+				return false;
+
+			for (std::size_t i = 0; i < lhsBody.size(); ++i)
+			{
+				if (lhsBody[i] != rhsBody[i])
+					return false;
+			}
+		}
+
+		return true;
+	}
+
+	// Compare tick par tick une simulation mono-thread (détection des collisions d'un bloc) et une simulation dont la détection
+	// est répartie entre plusieurs threads, à partir d'une même graine et avec les mêmes entrées
+	void CheckSimulationDeterminism(std::uint64_t seed)
+	{
+		const int width = 128;
+		const int height = 128;
+		const unsigned int snakeCount = 600;
+		const std::uint32_t tickCount = 1000;
+
+		Simulation serialSimulation(width, height, seed, 1);
+		Simulation parallelSimulation(width, height, seed, 4);
+		for (unsigned int snakeId = 1; snakeId <= snakeCount; ++snakeId)
+		{
+			serialSimulation.AddSnake(snakeId);
+			parallelSimulation.AddSnake(snakeId);
+		}
+
+		RandomGenerator random(seed + 1);
+		std::vector<SnakeInput> inputs;
+		std::size_t collisionCount = 0;
+		for (std::uint32_t tick = 0; tick < tickCount; ++tick)
+		{
+			// Un quart des serpents change de direction à chaque tick, certaines directions ayant été choisies sur un état trop ancien
+			inputs.clear();
+			for (unsigned int i = 0; i < snakeCount / 4; ++i)
+			{
+				SnakeInput& input = inputs.emplace_back();
+				input.snakeId = random.GenerateBelow(snakeCount) + 1;
+				input.direction = static_cast<SnakeDirection>(random.GenerateBelow(4));
+				input.tick = serialSimulation.GetTickIndex() - std::min(random.GenerateBelow(8), serialSimulation.GetTickIndex());
+			}
+
+			for (unsigned int i = 0; i < snakeCount / 20 + 1; ++i)
+			{
+				serialSimulation.SpawnApple();
+				parallelSimulation.SpawnApple();
+			}
+
+			// Des joueurs partent et reviennent de temps en temps
+			if (tick % 100 == 50)
+			{
+				unsigned int snakeId = random.GenerateBelow(snakeCount) + 1;
+				serialSimulation.RemoveSnake(snakeId);
+				parallelSimulation.RemoveSnake(snakeId);
+				serialSimulation.AddSnake(snakeId);
+				parallelSimulation.AddSnake(snakeId);
+			}
+
+			serialSimulation.ClearEvents();
+			parallelSimulation.ClearEvents();
+
+			serialSimulation.Tick(inputs);
+			parallelSimulation.Tick(inputs);
+
+			bool isSame = AreSameEvents(serialSimulation.GetEvents(), parallelSimulation.GetEvents()) &&
+			              AreSameSnakes(serialSimulation.GetSnakes(), parallelSimulation.GetSnakes()) &&
+			              AreSameGrids(serialSimulation.GetGrid(), parallelSimulation.GetGrid());
+
+			TEST_CHECK(isSame);
+			if (!isSame)
+				return; //< les ticks suivants divergeraient tous
+
+			for (const SimulationEvent& event : serialSimulation.GetEvents())
+			{
+				if (event.type == SimulationEventType::SnakeCollided)
+					collisionCount++;
+			}
+		}
+
+		// Le test n'a de sens que si des collisions entre serpents ont bien été résolues
+		TEST_CHECK(collisionCount > 0);
+	}
+}
+
+void TestSimulationDeterminism()
+{
+	// La détection des collisions répartie entre plusieurs threads ne doit rien changer à la partie :
+	// deux simulations de même graine recevant les mêmes entrées doivent rester identiques à chaque tick (pour plusieurs graines,
+	// chaque partie ne produisant qu'une partie des situations possibles)
+	for (std::uint64_t seed : { 1234, 5678, 42, 2024, 31337 })
+		CheckSimulationDeterminism(seed);
+}
@@ -0,0 +1,17 @@
+﻿#pragma once
+
+#include <cstddef>
+
+// Tests lancés par ts_main.cpp : chaque test vérifie ses résultats avec TEST_CHECK,
+// un test ayant au moins une vérification en échec étant considéré comme raté
+void TestBroadphase();
+void TestGridBitPlanes();
+void TestSimulationDeterminism();
+void TestSnakeBodyRoundTrip();
+void TestSnakeBodyPositionsFallback();
+void TestSnakeBodyTruncated();
+
+// Signale l'échec d'une vérification du test en cours
+void ReportTestFailure(const char* expression, const char* file, int line);
+
+#define TEST_CHECK(expression) do { if (!(expression)) ReportTestFailure(#expression, __FILE__, __LINE__); } while (false)